@@ -15,7 +15,6 @@
 #include "ai.h"
 #include <map>
 #include <vector>
-#include <sstream>
 #include <cmath>
 
 #include <iostream>
@@ -69,7 +68,7 @@ void GalconAI::init(std::list<Planet> & planets, const std::vector<ShipStats> &
 
 //Rebalances the distribution of ships on owned planets, minus the number of incoming
 //enemy ships. This is for defense against attackers. Returns a list of commands to be carried out.
-commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vector<ShipStats> & shipstats)
+commandList GalconAI::rebalance(const PlanetMap & map, const std::vector<ShipStats> & shipstats)
 {
   std::cout << "Rebalance) ";
   commandList ret;
@@ -84,21 +83,16 @@ commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vect
       
       def[(*i)] = (*i)->totalDefense(shipstats);
 
-      //Add or subtract incoming ships
-      for (fleetIterConst j = fleets.begin(); j != fleets.end(); j++)
+      //Add or subtract incoming ships, using the totals each planet keeps
+      for (int p = 0; p < (*i)->incomingPlayers(); p++)
 	{
-	  if (j->dest() == *i)
+	  if (p == player_)
 	    {
-	      int fleetShips = j->ships();
-	      
-	      if (j->owner() == player_)
-		{
-		  def[(*i)] += float(fleetShips) * shipstats[j->type()].attack;
-		}
-	      else
-		{
-		  def[(*i)] -= float(fleetShips) * shipstats[j->type()].attack;
-		}
+	      def[(*i)] += (*i)->incomingAttack(p, shipstats);
+	    }
+	  else
+	    {
+	      def[(*i)] -= (*i)->incomingAttack(p, shipstats);
 	    }
 	}
 
@@ -119,6 +113,7 @@ commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vect
   //Sort planets by surplus and defecit
   std::list<Planet*> surplus;
   std::list<Planet*> defecit;
+  std::vector<bool> inDefecit(map.size(), false);
   
   for (planetPtrIter i = planets_.begin(); i != planets_.end(); i++)
     {
@@ -135,6 +130,7 @@ commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vect
       if (def[(*i)] < desired / (1+set_.surplusDefecitThreshold))
 	{
 	  defecit.push_back(*i);
+	  inDefecit[(*i)->index()] = true;
 	}
     }
 
@@ -145,21 +141,15 @@ commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vect
       //If there are no more planets with defecit, break out
       if (defecit.size() == 0) break;
       
-      //Find nearest planet with defecit
+      //Find nearest planet with defecit, walking outwards from this one
       Planet* nearPlanet = NULL;
-      float nearDist = -1;
-
-      for (planetPtrIter j = defecit.begin(); j != defecit.end(); j++)
+      const int* nearest = map.nearest((*i)->index());
+      for (unsigned int j = 0; j + 1 < map.size(); j++)
 	{
-	  //Don't send to self
-	  if (i == j) break;
-
-	  float dist = ((*i)->center() - (*j)->center()).length();
-	  
-	  if (dist < nearDist || nearPlanet == NULL)
+	  if (inDefecit[nearest[j]])
 	    {
-	      nearDist = dist;
-	      nearPlanet = (*j);
+	      nearPlanet = map.planet(nearest[j]);
+	      break;
 	    }
 	}
       
@@ -186,6 +176,7 @@ commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vect
 	      if ((*j) == nearPlanet)
 		{
 		  defecit.erase(j);
+		  inDefecit[nearPlanet->index()] = false;
 		  break;
 		}
 	    }
@@ -204,36 +195,58 @@ commandList GalconAI::rebalance(const std::list<Fleet> & fleets, const std::vect
 }
 
 //Computes the optimal target to attack and stores the result.
-void GalconAI::computeTarget(std::list<Planet> & planets, const std::list<Fleet> & fleets, const std::vector<ShipStats> & shipstats)
+void GalconAI::computeTarget(std::list<Planet> & planets, const PlanetMap & map, const std::vector<ShipStats> & shipstats)
 {
-  //Store the distance from each planet to the nearest owned planet
-  std::map<Planet*, float> distWeight;
+  //Raise every distance to distancePower once, since planets never move
+  if (distWeight_.size() != map.size()*map.size())
+    {
+      distWeight_.resize(map.size()*map.size());
+      for (unsigned int a = 0; a < map.size(); a++)
+	{
+	  for (unsigned int b = 0; b < map.size(); b++)
+	    {
+	      distWeight_[a*map.size() + b] = pow(map.distance(a, b), set_.distancePower);
+	    }
+	}
+    }
+
+  //Mark the planets owned
+  std::vector<bool> owned(map.size(), false);
+  for (planetPtrIter j = planets_.begin(); j != planets_.end(); j++)
+    {
+      owned[(*j)->index()] = true;
+    }
+
+  //Store the distance from each planet to the nearest owned planet, and how long
+  //ships of the basic type take to fly from there
+  std::vector<float> distWeight(map.size(), -1);
+  std::vector<float> closestTime(map.size(), -1);
   float maximin = 0;
   for (planetIter i = planets.begin(); i != planets.end(); i++)
     {
       //Don't store distance to planets you own
       if (i->owner() == player_) continue;
 
-      //Find the closest
-      float closestDist = -1;
-
-      for (planetPtrIter j = planets_.begin(); j != planets_.end(); j++)
+      //Find the closest by walking outwards through the neighbours
+      int closest = -1;
+      const int* nearest = map.nearest(i->index());
+      for (unsigned int j = 0; j + 1 < map.size(); j++)
 	{
-	  //If it's closer
-	  if (((*j)->center() - i->center()).length() < closestDist || closestDist == -1)
+	  if (owned[nearest[j]])
 	    {
-	      closestDist = ((*j)->center() - i->center()).length();
+	      closest = nearest[j];
+	      break;
 	    }
 	}
+      if (closest < 0) continue;
 
-      //We want the distance weighting to grow exponentially
-      closestDist = pow(closestDist, set_.distancePower);
+      closestTime[i->index()] = map.travelTime(closest, i->index(), 0);
 
-      //Add it to the map
-      distWeight[&(*i)] = closestDist;
+      //We want the distance weighting to grow exponentially
+      distWeight[i->index()] = distWeight_[i->index()*map.size() + closest];
 
       //Update maximin if needed
-      if (closestDist > maximin) maximin = closestDist;
+      if (distWeight[i->index()] > maximin) maximin = distWeight[i->index()];
     }
   
   //Find the best target
@@ -242,46 +255,36 @@ void GalconAI::computeTarget(std::list<Planet> & planets, const std::list<Fleet>
 
   for (planetIter i = planets.begin(); i != planets.end(); i++)
     {
-      //Don't attack a planet you own
-      if (i->owner() == player_) continue;
+      //Don't attack a planet you own, or any planet if you own none
+      if (i->owner() == player_ || distWeight[i->index()] < 0) continue;
       
       //Find total defense
       float defense = i->totalDefense(shipstats);
 
       //Take into account any fleets moving to this planet
-      for (fleetIterConst k = fleets.begin(); k != fleets.end(); k++)
-	{
-	  //Only do stuff for fleets going to this planet
-	  if (k->dest() != &(*i)) continue;
+      //Fleets owned by the owner of the planet add their defense
+      defense += i->incomingDefense(i->owner(), shipstats);
 
-	  //Fleet owned by owner of planet
-	  if (k->owner() == i->owner())
-	    {
-	      //Add the defense
-	      defense += k->totalDefense(shipstats);
-	    }
-	  else if (k->owner() != i->owner() && k->owner() != player_) //Third party
-	    {
-	      //Subtract the attack of the fleet
-	      defense -= k->totalAttack(shipstats);
-
-	      //If the attacker would win, its ships take defense
-	      if (defense < 0) defense *= -1;
-	    }
-	  //We don't care about our own fleets
+      //Third parties subtract their attack. We don't care about our own fleets.
+      for (int p = 0; p < i->incomingPlayers(); p++)
+	{
+	  if (p == i->owner() || p == player_) continue;
+	  defense -= i->incomingAttack(p, shipstats);
 	}
 
+      //If the attackers would win, their ships take defense
+      if (defense < 0) defense *= -1;
+
       //Add any ships that would be created during the flight
       //Ignore construction from buildings for now...
-      float travelTime = pow(distWeight[&(*i)], 1.0/set_.distancePower)/float(DEFAULT_FLEET_SPEED);
-      defense += travelTime * i->size();
+      defense += closestTime[i->index()] * i->size();
 
       
       //Compute ratio
       float ratio = (defense+3) / i->size();
 
       //Weight it by distance
-      ratio *= distWeight[&(*i)] / maximin;
+      ratio *= distWeight[i->index()] / maximin;
 
       //Weight it by size (prioritizing small)
       ratio *= i->size();
@@ -302,7 +305,7 @@ void GalconAI::computeTarget(std::list<Planet> & planets, const std::list<Fleet>
 
 //Checks to see if it's ready to attack the target planet.
 //If so, return some commands to be executed
-commandList GalconAI::attack(const std::vector<ShipStats> & shipstats)
+commandList GalconAI::attack(const PlanetMap & map, const std::vector<ShipStats> & shipstats)
 {
   //Create return commandList
   commandList ret;
@@ -338,34 +341,26 @@ commandList GalconAI::attack(const std::vector<ShipStats> & shipstats)
   if (attTotal_ < attack) return ret;
 
   //Since we have enough ships to attack, send from nearest planets
-  //Copy the list of owned planets
-  std::list<Planet*> unused;
+  //Walk outwards from the target through the owned planets
+  std::vector<bool> owned(map.size(), false);
   for (planetPtrIter i = planets_.begin(); i != planets_.end(); i++)
     {
-      unused.push_back(*i);
+      owned[(*i)->index()] = true;
     }
+  const int* nearest = map.nearest(target_->index());
+  unsigned int next = 0;
   
   //While we have not met the required amount
   float currentTotal = 0;
   while (currentTotal < attack)
     {
-      //If there are no unused planets left, get out
-      if (unused.size() == 0) break;
-      
       //Find the nearest unused planet
-      Planet* nearestPlanet = NULL;
-      float nearestDist = -1;
+      while (next + 1 < map.size() && !owned[nearest[next]]) next++;
 
-      planetPtrIter i;
-      for (i = unused.begin(); i != unused.end(); i++)
-	{
-	  float dist = (target_->center() - (*i)->center()).length();
-	  if (dist < nearestDist || nearestPlanet == NULL)
-	    {
-	      nearestPlanet = (*i);
-	      nearestDist = dist;
-	    }
-	}
+      //If there are no unused planets left, get out
+      if (next + 1 >= map.size()) break;
+      Planet* nearestPlanet = map.planet(nearest[next]);
+      next++;
 
       //Send ships from this planet to the target
       //Find total attack potential
@@ -386,16 +381,6 @@ commandList GalconAI::attack(const std::vector<ShipStats> & shipstats)
 
       //Increase the current total
       currentTotal += planetAttack;
-
-      //Don't use this planet again
-      for (i = unused.begin(); i != unused.end(); i++)
-	{
-	  if ((*i) == nearestPlanet)
-	    {
-	      unused.erase(i);
-	      break;
-	    }
-	}
     }
 
   //Move currentTotal ships from attack to defense
@@ -444,26 +429,14 @@ commandList GalconAI::build(const std::vector<std::list<Building*> > buildRules,
 	  //Make sure it's currently operational
 	  if (!build->exists() || int(j) == (*i)->buildIndex()) continue;
 
-	  //Parse it
-	  std::stringstream ss(build->effect());
-	  std::string item;
-	  std::vector<std::string> tokens;
-	  while (std::getline(ss, item, ' '))
-	    {
-	      tokens.push_back(item);
-	    }
-
 	  //Only handle buildings that build ships
-	  if (tokens[0] == "build")
+	  const BuildingEffect& effect = build->effect();
+	  if (effect.type == EFFECT_BUILD)
 	    {
-	      //Must have a size of 3
-	      if (tokens.size() == 3)
-		{
-		  //Add this building's production to the total
-		  int index = atoi(tokens[1].c_str());
-		  totalBuildRate += (1/atoi(tokens[2].c_str())) *
-		    (shipstats[index].attack + shipstats[index].defense);
-		}
+	      //Add this building's production to the total
+	      int index = effect.shipType;
+	      totalBuildRate += (1/effect.interval) *
+		(shipstats[index].attack + shipstats[index].defense);
 	    }
 	}
     }
@@ -554,23 +527,23 @@ commandList GalconAI::build(const std::vector<std::list<Building*> > buildRules,
 }
   
 //An easy to use, do-everything-in-one-call sort of function
-commandList GalconAI::update(std::list<Planet> & planets, const std::list<Fleet> & fleets, const std::vector<ShipStats> & shipstats, std::vector<std::list<Building*> > buildRules)
+commandList GalconAI::update(std::list<Planet> & planets, const PlanetMap & map, const std::vector<ShipStats> & shipstats, std::vector<std::list<Building*> > buildRules, const SimClock& clock)
 {
   //Set up the list of commands
   commandList rb;
   
   //See if we have waited long enough and the AI is active
-  int time = SDL_GetTicks();
+  int time = clock.time();
   if ((time - updateTime_ < set_.delay && updateTime_ != -1) || !active_) return rb;
   updateTime_ = time;
   std::cout << "Update) Attack: " << attTotal_ << " Defense: " << defTotal_ << std::endl;
 
   //Compute the best target
-  computeTarget(planets, fleets, shipstats);
+  computeTarget(planets, map, shipstats);
 
   //Get the commands from rebalancing, attacking, and building
-  rb = rebalance(fleets, shipstats);
-  commandList at = attack(shipstats);
+  rb = rebalance(map, shipstats);
+  commandList at = attack(map, shipstats);
   commandList bd = build(buildRules, shipstats);
 
   //Append at to rb
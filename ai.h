@@ -17,6 +17,8 @@
 #include "SDL/SDL.h"
 #include "planet.h"
 #include "fleet.h"
+#include "planetmap.h"
+#include "simclock.h"
 
 typedef std::list<std::pair<Planet*,std::pair<int, Planet*> > > commandList;
 
@@ -79,11 +81,11 @@ class GalconAI
 
   //General use functions
   void init(std::list<Planet> & planets, const std::vector<ShipStats> & shipstats);
-  commandList rebalance(const std::list<Fleet> & fleets, const std::vector<ShipStats> & shipstats);
-  void computeTarget(std::list<Planet> & planets, const std::list<Fleet> & fleets, const std::vector<ShipStats> & shipstats);
-  commandList attack(const std::vector<ShipStats> & shipstats);
+  commandList rebalance(const PlanetMap & map, const std::vector<ShipStats> & shipstats);
+  void computeTarget(std::list<Planet> & planets, const PlanetMap & map, const std::vector<ShipStats> & shipstats);
+  commandList attack(const PlanetMap & map, const std::vector<ShipStats> & shipstats);
   commandList build(const std::vector<std::list<Building*> > buildRules, const std::vector<ShipStats> & shipstats);
-  commandList update(std::list<Planet> & planets, const std::list<Fleet> & fleets, const std::vector<ShipStats> & shipstats, std::vector<std::list<Building*> > buildRules);
+  commandList update(std::list<Planet> & planets, const PlanetMap & map, const std::vector<ShipStats> & shipstats, std::vector<std::list<Building*> > buildRules, const SimClock& clock);
 
   //Notifiers
   void notifyConstruction(float attack, float defense);
@@ -113,8 +115,11 @@ class GalconAI
   //The AI settings
   GalconAISettings set_;
 
-  //The time of the last update call
+  //The simulated time of the last update call
   int updateTime_;
+
+  //Distances between planets raised to set_.distancePower, filled in on first use
+  std::vector<float> distWeight_;
 };
 
 #endif
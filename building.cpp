@@ -10,6 +10,9 @@
 */
 
 #include "building.h"
+#include <sstream>
+#include <vector>
+#include <cstdlib>
 
 #ifndef _building_cpp_
 #define _building_cpp_
@@ -17,60 +20,82 @@
 //Default constructor, won't do much
 Building::Building()
 {
-  effect_ = "none";
+  setEffect("none");
 }
 
 //Regular constructor
-//The inputted SDL_Surface will be copied away and does not have to be maintained
+//The rotations are shared through the RotationRegistry, so the surfaces must outlive the building
 Building::Building(SDL_Surface* surf, SDL_Surface* consSurf, std::string effect):
-  image_(RotationCache(surf, NUM_BUILDING_ROTATIONS)),
-  constructionImage_(RotationCache(consSurf, NUM_BUILDING_ROTATIONS)),
-  effect_(effect),
+  image_(surf, 1, NUM_BUILDING_ROTATIONS, BUILDING_ROTATION_FILTER),
+  constructionImage_(consSurf, 1, NUM_BUILDING_ROTATIONS, BUILDING_ROTATION_FILTER),
   buildtime_(1000),
   cd_(2000),
   range_(1000)
 {
+  setEffect(effect);
 }
 
-//Displays the building to the given coordinates
-void Building::display(Vec2f pos, float angle, SDL_Surface* screen, bool complete)
+//Sets the effect string and parses it into the effect descriptor
+//This is the only place effect strings are read
+void Building::setEffect(const std::string& effect)
 {
-  //Blit it
-  SDL_Rect outrect;
-  outrect.x = pos.x();
-  outrect.y = pos.y();
-  if (complete)
+  effect_ = effect;
+
+  //Start with an effect that does nothing
+  parsed_.type = EFFECT_NONE;
+  parsed_.shipType = 0;
+  parsed_.interval = 0;
+  parsed_.payload.kind = PAYLOAD_NONE;
+  parsed_.payload.amount = 0;
+  parsed_.speed = 0;
+  parsed_.total = false;
+
+  //Create a string stream and vector for tokens
+  std::stringstream ss(effect);
+  std::string item;
+  std::vector<std::string> tokens;
+  while (std::getline(ss, item, ' '))
     {
-      SDL_BlitSurface(image_.rotation(angle), NULL, screen, &outrect);
+      tokens.push_back(item);
     }
-  else
+  if (tokens.size() == 0) return;
+
+  //Build ships: build <shiptype> <secondinterval>
+  if (tokens[0] == "build")
     {
-      SDL_BlitSurface(constructionImage_.rotation(angle), NULL, screen, &outrect);
+      //Ensure size of 3 and a positive interval
+      if (tokens.size() != 3) return;
+      parsed_.shipType = std::atoi(tokens[1].c_str());
+      parsed_.interval = std::atof(tokens[2].c_str());
+      if (parsed_.interval <= 0) return;
+      parsed_.type = EFFECT_BUILD;
+      return;
     }
-}
 
-//Returns either the unrotated image if no args, or the rotation at the given angle
-SDL_Surface* Building::rotation(float angle, bool complete)
-{
-  //Complete
-  if (complete)
+  //Fire and aura both start with a payload: <payload> <amount>
+  if (tokens[0] != "fire" && tokens[0] != "aura") return;
+  if (tokens.size() < 3) return;
+  if (tokens[1] == "damage")
     {
-      //No args, or uninformed user
-      if (angle < 0)
-	{
-	  return image_.rotation(0);
-	}
-      return image_.rotation(angle);
+      parsed_.payload.kind = PAYLOAD_DAMAGE;
     }
-  else
+  else return;
+  parsed_.payload.amount = std::atof(tokens[2].c_str());
+
+  //Fire projectile: fire <payload> <amount> <speed as multiplier>
+  if (tokens[0] == "fire")
     {
-      //No args, or uninformed user
-      if (angle < 0)
-	{
-	  return constructionImage_.rotation(0);
-	}
-      return constructionImage_.rotation(angle);
+      //Ensure size of four
+      if (tokens.size() != 4) return;
+      parsed_.speed = std::atof(tokens[3].c_str());
+      parsed_.type = EFFECT_FIRE;
+      return;
     }
+
+  //Aura: aura <payload> <amount> [total]
+  if (tokens.size() > 4) return;
+  parsed_.total = (tokens.size() == 4 && tokens[3] == "total");
+  parsed_.type = EFFECT_AURA;
 }
 
 #endif
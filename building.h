@@ -10,50 +10,89 @@
 */
 
 #include "SDL/SDL.h"
-#include "rotationcache.h"
+#include "rotationregistry.h"
 #include "vec2f.h"
+#include "payload.h"
 #include <string>
 
 #ifndef _building_h_
 #define _building_h_
 
-const int NUM_BUILDING_ROTATIONS = 500;
+//Bilinear rotations look smooth with far fewer of them stored
+const int NUM_BUILDING_ROTATIONS = 128;
+const RotationFilter BUILDING_ROTATION_FILTER = ROTATION_BILINEAR;
 const int BUILDING_WIDTH = 50;
 
+//The kinds of effects a building can have
+const char EFFECT_NONE = 0;
+const char EFFECT_BUILD = 1;
+const char EFFECT_FIRE = 2;
+const char EFFECT_AURA = 3;
+
+//A building's effect string, parsed once into its type and arguments
+//Malformed or unknown effects are parsed as EFFECT_NONE
+struct BuildingEffect
+{
+  //One of the EFFECT_ constants
+  char type;
+
+  //Build ships: build <shiptype> <secondinterval>
+  int shipType;
+  float interval;
+
+  //Fire projectile: fire <payload> <amount> <speed as multiplier>
+  //Aura: aura <payload> <amount> [total]
+  //With "total", the amount is split between all fleets in range
+  Payload payload;
+  float speed;
+  bool total;
+};
+
 class Building
 {
  public:
   //Constructors
+  //Copies share the rotations of the original
   Building();
   Building(SDL_Surface* surf, SDL_Surface* consSurf, std::string effect);
 
   //Regular use functions
-  void display(Vec2f pos, float angle, SDL_Surface* screen, bool complete);
+  void precache() {
+    if (!image_.empty()) image_->precacheAsync();
+    if (!constructionImage_.empty()) constructionImage_->precacheAsync();}
 
   //Accessors
-  SDL_Surface* rotation(float angle = -1, bool complete = true);
-  const std::string effect() const {return effect_;}
+  const SharedRotation& sprite(bool complete = true) const {return complete ? image_ : constructionImage_;}
+  const BuildingEffect& effect() const {return parsed_;}
+  const std::string& effectString() const {return effect_;}
   int buildtime() const {return buildtime_;}
   int cd() const {return cd_;}
   int range() const {return range_;}
 
+  //Size of every rotation of the building, without looking any of them up
+  int width() const {return image_.empty() ? 0 : image_->width();}
+  int height() const {return image_.empty() ? 0 : image_->height();}
+
   //Mutators
-  void setImage(SDL_Surface* surf) {image_ = RotationCache(surf, NUM_BUILDING_ROTATIONS);}
-  void setConstructionImage(SDL_Surface* surf) {constructionImage_ = RotationCache(surf, NUM_BUILDING_ROTATIONS);}
-  void setEffect(const std::string& effect) {effect_ = effect;}
+  void setImage(SDL_Surface* surf) {image_ = SharedRotation(surf, 1, NUM_BUILDING_ROTATIONS, BUILDING_ROTATION_FILTER);}
+  void setConstructionImage(SDL_Surface* surf) {constructionImage_ = SharedRotation(surf, 1, NUM_BUILDING_ROTATIONS, BUILDING_ROTATION_FILTER);}
+  void setEffect(const std::string& effect);
   void setBuildTime(const int t) {buildtime_ = t;}
   void setCD(const int cd) {cd_ = cd;}
   void setRange(const int range) {range_ = range;}
 
  private:
-  //The images for the building
-  RotationCache image_;
-  RotationCache constructionImage_;
+  //The images for the building, shared with any building using the same image
+  SharedRotation image_;
+  SharedRotation constructionImage_;
 
   //The "effect" of the building as a string to be parsed
   //This is in form "effect1 var1 var2 ... varn and effect2 var1 var2 ... varn"
   std::string effect_;
 
+  //The effect after parsing
+  BuildingEffect parsed_;
+
   //The amount of time, in milliseconds, it takes to construct this building
   int buildtime_;
 
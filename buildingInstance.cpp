@@ -17,30 +17,22 @@
 //Default constructor
 BuildingInstance::BuildingInstance() :
   type_(NULL),
-  projectileTime_(0),
-  time_(0)
+  projectileTime_(0)
 {}
 
 //Regular constructor
 BuildingInstance::BuildingInstance(Building* type) :
   type_(type),
-  projectileTime_(0),
-  time_(0)
+  projectileTime_(0)
 {}
 
 //Progresses the building
-void BuildingInstance::update()
+void BuildingInstance::update(const SimClock& clock)
 {
-  //Find time since last call
-  if (time_ == 0) {time_ = SDL_GetTicks(); return;}
-  int currentTime = SDL_GetTicks();
-  int dt = currentTime - time_;
-  time_ = currentTime;
-
   //Update projectileTime_ if the building exists
   if (type_ != NULL)
     {
-      projectileTime_ += dt;
+      projectileTime_ += clock.dt();
 
       //Do not allow projectileTime to store up extra shots
       if (projectileTime_ > type_->cd()) projectileTime_ = type_->cd();
@@ -52,7 +44,6 @@ void BuildingInstance::destroy()
 {
   type_ = NULL;
   projectileTime_ = 0;
-  time_ = 0;
 }
 
 //Fires a projectile. Here, this only reduces projectileTime_ appropriately
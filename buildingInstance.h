@@ -14,6 +14,7 @@
 
 #include "building.h"
 #include "vec2f.h"
+#include "simclock.h"
 
 #ifndef _buildinginstance_h_
 #define _buildinginstance_h_
@@ -30,22 +31,20 @@ class BuildingInstance
   int projectileTime() const {return projectileTime_;}
   bool exists() const {return type_ != NULL;}
   //Building variables
-  SDL_Surface* rotation(float angle = -1, bool complete = true)
-  {return type_->rotation(angle, complete);}
-  std::string effect() const {return type_->effect();}
+  const SharedRotation& sprite(bool complete = true) const {return type_->sprite(complete);}
+  const BuildingEffect& effect() const {return type_->effect();}
   int buildtime() const {return type_->buildtime();}
   float cd() const {return type_->cd();}
   int range() const {return type_->range();}
   bool canFire() const {return projectileTime_ >= type_->cd();}
+  int width() const {return type_->width();}
+  int height() const {return type_->height();}
 
   //Regular use functions
   //BuildingInstance
-  void update();
+  void update(const SimClock& clock);
   void destroy();
   bool fire();
-  //Building
-  void display(Vec2f pos, float angle, SDL_Surface* screen, bool complete)
-  {type_->display(pos, angle, screen, complete);}
   
  private:
   //Pointer to the building type represented
@@ -53,9 +52,6 @@ class BuildingInstance
 
   //The time since the last time this building fired its projectile
   int projectileTime_;
-
-  //The time of the last progress() call
-  int time_;
 };
 
 #endif
@@ -0,0 +1,164 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----DirtyRects Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the DirtyRects class.
+*/
+
+#ifndef _dirtyrects_cpp_
+#define _dirtyrects_cpp_
+
+#include "dirtyrects.h"
+#include <algorithm>
+
+//Constructor, the first frame is drawn in full
+DirtyRects::DirtyRects(int w, int h):
+  w_(w),
+  h_(h),
+  full_(true),
+  updatedArea_(0)
+{}
+
+//Orders items by every field, so two frames can be compared after sorting
+bool DirtyRects::Item::operator<(const Item& i) const
+{
+  if (rect.x != i.rect.x) return rect.x < i.rect.x;
+  if (rect.y != i.rect.y) return rect.y < i.rect.y;
+  if (rect.w != i.rect.w) return rect.w < i.rect.w;
+  if (rect.h != i.rect.h) return rect.h < i.rect.h;
+  if (source != i.source) return source < i.source;
+  return variant < i.variant;
+}
+
+bool DirtyRects::Item::operator==(const Item& i) const
+{
+  return rect.x == i.rect.x && rect.y == i.rect.y && rect.w == i.rect.w &&
+    rect.h == i.rect.h && source == i.source && variant == i.variant;
+}
+
+//Records something drawn this frame, clipped to the screen
+void DirtyRects::mark(int x, int y, int w, int h, const void* source, Uint32 variant)
+{
+  //Clip to the screen, ignoring anything entirely off of it
+  if (x < 0) {w += x; x = 0;}
+  if (y < 0) {h += y; y = 0;}
+  if (x + w > w_) w = w_ - x;
+  if (y + h > h_) h = h_ - y;
+  if (w <= 0 || h <= 0) return;
+
+  Item item = {{Sint16(x), Sint16(y), Uint16(w), Uint16(h)}, source, variant};
+  current_.push_back(item);
+}
+
+void DirtyRects::mark(const SDL_Rect& rect, const void* source, Uint32 variant)
+{
+  mark(rect.x, rect.y, rect.w, rect.h, source, variant);
+}
+
+//Start of a frame, fills everything drawn last frame with color
+void DirtyRects::clear(SDL_Surface* screen, Uint32 color)
+{
+  current_.clear();
+  if (full_)
+    {
+      SDL_FillRect(screen, NULL, color);
+      return;
+    }
+
+  for (unsigned int i = 0; i < last_.size(); i++)
+    {
+      //SDL_FillRect clips the rectangle it is given, so pass a copy
+      SDL_Rect r = last_[i].rect;
+      SDL_FillRect(screen, &r, color);
+    }
+}
+
+//End of a frame, sends the changed areas of the screen to the display
+void DirtyRects::present(SDL_Surface* screen)
+{
+  std::sort(current_.begin(), current_.end());
+
+  //Find everything that appeared, moved, changed or disappeared
+  update_.clear();
+  if (!full_)
+    {
+      addChanged(last_, current_);
+      addChanged(current_, last_);
+      coalesce();
+    }
+
+  long area = 0;
+  for (unsigned int i = 0; i < update_.size(); i++)
+    {
+      area += long(update_[i].w) * update_[i].h;
+    }
+
+  //One big update is cheaper than many that cover most of the screen anyway
+  if (full_ || area > DIRTY_FULL_FRACTION * w_ * h_)
+    {
+      SDL_UpdateRect(screen, 0, 0, 0, 0);
+      updatedArea_ = long(w_) * h_;
+    }
+  else
+    {
+      if (!update_.empty()) SDL_UpdateRects(screen, update_.size(), &update_[0]);
+      updatedArea_ = area;
+    }
+
+  //This frame becomes the one to compare against
+  last_.swap(current_);
+  current_.clear();
+  full_ = false;
+}
+
+//Adds the rectangles of items in a but not in b to update_
+void DirtyRects::addChanged(const std::vector<Item>& a, const std::vector<Item>& b)
+{
+  std::vector<Item>::const_iterator j = b.begin();
+  for (std::vector<Item>::const_iterator i = a.begin(); i != a.end(); i++)
+    {
+      while (j != b.end() && *j < *i) j++;
+      if (j != b.end() && *j == *i)
+	{
+	  j++;
+	  continue;
+	}
+      update_.push_back(i->rect);
+    }
+}
+
+//Merges overlapping rectangles in update_ until none overlap
+//Only a handful of things change each frame, so checking every pair is fine
+void DirtyRects::coalesce()
+{
+  bool merged = true;
+  while (merged)
+    {
+      merged = false;
+      for (unsigned int i = 0; i < update_.size(); i++)
+	{
+	  for (unsigned int j = i + 1; j < update_.size(); j++)
+	    {
+	      SDL_Rect& a = update_[i];
+	      const SDL_Rect& b = update_[j];
+	      if (a.x >= b.x + b.w || b.x >= a.x + a.w ||
+		  a.y >= b.y + b.h || b.y >= a.y + a.h) continue;
+
+	      //Replace a with the bounds of both, and drop b
+	      int x1 = std::min(a.x, b.x), y1 = std::min(a.y, b.y);
+	      int x2 = std::max(a.x + a.w, b.x + b.w), y2 = std::max(a.y + a.h, b.y + b.h);
+	      a.x = x1; a.y = y1; a.w = x2 - x1; a.h = y2 - y1;
+	      update_[j] = update_.back();
+	      update_.pop_back();
+	      merged = true;
+	      j = i;
+	    }
+	}
+    }
+}
+
+#endif
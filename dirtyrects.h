@@ -0,0 +1,97 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----DirtyRects Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Keeps track of what was drawn where on the screen, so that each frame only
+  the areas that changed are cleared and sent to the display.
+
+  Everything drawn is marked with its bounds and what it showed there, such as
+  a surface and the part of it blitted. At the start of a frame the areas drawn
+  last frame are filled with the background, then everything is drawn again.
+  At the end, anything drawn last frame but not this one, or this frame but
+  not the last, is sent to the display with SDL_UpdateRects. Areas that only
+  had the same things drawn in the same place end up with the same pixels, so
+  they are left alone.
+
+  Anything drawn without being marked will not be cleared, so every draw
+  between clear and present must be marked.
+*/
+
+#ifndef _dirtyrects_h_
+#define _dirtyrects_h_
+
+#include "SDL/SDL.h"
+#include <vector>
+
+//If the changed areas add up to more than this fraction of the screen,
+//the whole screen is sent at once instead
+const float DIRTY_FULL_FRACTION = 0.5;
+
+class DirtyRects
+{
+ public:
+  //Constructors
+  //Takes the size of the screen. The first frame is always drawn in full.
+  DirtyRects(int w, int h);
+
+  //Records something drawn this frame covering rect
+  //source and variant identify what was drawn, like a surface and which part
+  //of it, or NULL and a fill color
+  void mark(const SDL_Rect& rect, const void* source, Uint32 variant);
+  void mark(int x, int y, int w, int h, const void* source, Uint32 variant);
+
+  //Makes the next frame clear and send the whole screen
+  //Needed whenever everything moves at once, like when the camera moves
+  void invalidate() {full_ = true;}
+
+  //Start of a frame, fills everything drawn last frame with color
+  void clear(SDL_Surface* screen, Uint32 color);
+
+  //End of a frame, sends the changed areas of the screen to the display
+  void present(SDL_Surface* screen);
+
+  //Accessors
+  //The number of pixels sent by the last present
+  long updatedArea() const {return updatedArea_;}
+
+ private:
+  //One thing drawn, and where
+  struct Item
+  {
+    SDL_Rect rect;
+    const void* source;
+    Uint32 variant;
+
+    bool operator<(const Item& i) const;
+    bool operator==(const Item& i) const;
+  };
+
+  //Adds the rectangles of items in a but not in b to update_
+  //Both must be sorted
+  void addChanged(const std::vector<Item>& a, const std::vector<Item>& b);
+
+  //Merges overlapping rectangles in update_ until none overlap
+  void coalesce();
+
+  //Size of the screen
+  int w_, h_;
+
+  //What was drawn last frame, and so far this frame
+  std::vector<Item> last_;
+  std::vector<Item> current_;
+
+  //The areas to send to the display, reused between frames
+  std::vector<SDL_Rect> update_;
+
+  //Whether the whole screen has to be cleared and sent
+  bool full_;
+
+  //Pixels sent by the last present
+  long updatedArea_;
+};
+
+#endif
@@ -8,18 +8,21 @@
 
   Contains the declaration for the Fleet class.
 
-  As a note: For a small increase in memory cost, we could lose the dependency on
-  planet.h and just store the planet's size. Could help if circular dependencies
-  need resolving.
+  The fleets themselves are stored in a FleetStore. A Fleet is a lightweight
+  view of one fleet in a store, and is only valid until the store changes.
+  Hold a FleetId to refer to a fleet for longer.
 */
 
 #ifndef _fleet_h_
 #define _fleet_h_
 
 #include <vector>
+#include "SDL/SDL.h"
 #include "vec2f.h"
 #include "planet.h"
 #include "shipstats.h"
+#include "fleetid.h"
+#include "fleetstore.h"
 
 const int DEFAULT_FLEET_SPEED = 60;
 const int DEFAULT_INTERCEPT_CD = 500;
@@ -29,56 +32,30 @@ class Fleet
  public:
   //Constructors
   Fleet();
-  Fleet(int inships, int intype, ShipStats shipstats, Planet* begin, Planet* end);
+  Fleet(FleetStore* store, unsigned int index);
 
   //Accessors
-  Vec2f pos() const {return pos_;}
-  double x() const {return pos_.x();}
-  double y() const {return pos_.y();}
-  Vec2f vel() const;
-  int ships() const {return ships_;}
-  int type() const {return type_;}
-  Planet* dest() const {return dest_;}
-  int owner() const {return owner_;}
-  float totalAttack(const std::vector<ShipStats> & shipstats) const;
-  float totalDefense(const std::vector<ShipStats> & shipstats) const;
+  Vec2f pos() const {return store_->pos(index_);}
+  double x() const {return store_->x(index_);}
+  double y() const {return store_->y(index_);}
+  Vec2f vel() const {return store_->vel(index_);}
+  int ships() const {return store_->ships(index_);}
+  int type() const {return store_->type(index_);}
+  Planet* dest() const {return store_->dest(index_);}
+  int owner() const {return store_->owner(index_);}
+  FleetId id() const {return store_->id(index_);}
+  unsigned int index() const {return index_;}
+  float totalAttack(const std::vector<ShipStats> & shipstats) const {return store_->totalAttack(index_, shipstats);}
+  float totalDefense(const std::vector<ShipStats> & shipstats) const {return store_->totalDefense(index_, shipstats);}
 
   //General use functions
-  void update();
-  void display(SDL_Surface* screen, const SDL_Rect& camera);
-  bool takeHit(int damage, const std::vector<ShipStats> & shipstats);
-  char intercept(Fleet* target, const std::vector<ShipStats> & shipstats);
+  bool takeHit(int damage, const std::vector<ShipStats> & shipstats) {return store_->takeHit(index_, damage, shipstats);}
+  char intercept(const Fleet& target, const std::vector<ShipStats> & shipstats) {return store_->intercept(index_, target.index_, shipstats);}
   
  private:
-  //Current coordinates of the fleet
-  Vec2f pos_;
-
-  //Destination planet
-  Planet* dest_;
-
-  //The speed, in pixels/second
-  int speed_;
-
-  //The count of ships
-  int ships_;
-
-  //The type of ship
-  int type_;
-
-  //The ticks at the last time update was called
-  int lastTicks_;
-
-  //The ticks at the last time an interception shot was fired
-  int lastIntercept_;
-
-  //The owner of the fleet
-  int owner_;
-
-  //Variables to keep track of accumulated, yet unapplied, damage
-  int damage_;
+  //The store holding the fleet, and the fleet's packed index in it
+  FleetStore* store_;
+  unsigned int index_;
 };
 
-typedef std::list<Fleet>::iterator fleetIter;
-typedef std::list<Fleet>::const_iterator fleetIterConst;
-
 #endif
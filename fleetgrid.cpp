@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----FleetGrid Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the FleetGrid class.
+*/
+
+#ifndef _fleetgrid_cpp_
+#define _fleetgrid_cpp_
+
+#include "fleetgrid.h"
+#include <algorithm>
+
+//Default constructor, the grid starts out empty
+FleetGrid::FleetGrid() :
+  cellSize_(1),
+  left_(0),
+  top_(0),
+  columns_(0),
+  rows_(0)
+{}
+
+//Sorts the fleets into cells of the given size
+void FleetGrid::build(const FleetStore& fleets, float cellSize)
+{
+  cellSize_ = (cellSize < 1) ? 1 : cellSize;
+  fleets_.clear();
+  start_.assign(1, 0);
+  columns_ = rows_ = 0;
+  if (fleets.empty()) return;
+
+  //Find the bounds of all fleets
+  double right = fleets.x(0);
+  double bottom = fleets.y(0);
+  left_ = right;
+  top_ = bottom;
+  for (unsigned int i = 0; i < fleets.size(); i++)
+    {
+      left_ = std::min(left_, double(fleets.x(i)));
+      top_ = std::min(top_, double(fleets.y(i)));
+      right = std::max(right, double(fleets.x(i)));
+      bottom = std::max(bottom, double(fleets.y(i)));
+    }
+
+  columns_ = int((right - left_) / cellSize_) + 1;
+  rows_ = int((bottom - top_) / cellSize_) + 1;
+
+  //Count the fleets in each cell, then turn the counts into starting offsets
+  std::vector<int> cells(fleets.size());
+  start_.assign(columns_ * rows_ + 1, 0);
+  for (unsigned int i = 0; i < fleets.size(); i++)
+    {
+      cells[i] = row(fleets.y(i)) * columns_ + column(fleets.x(i));
+      start_[cells[i] + 1]++;
+    }
+  for (unsigned int c = 1; c < start_.size(); c++)
+    {
+      start_[c] += start_[c-1];
+    }
+
+  //Place each fleet in its cell
+  std::vector<int> next(start_.begin(), start_.end() - 1);
+  fleets_.resize(fleets.size());
+  for (unsigned int i = 0; i < fleets.size(); i++)
+    {
+      fleets_[next[cells[i]]++] = i;
+    }
+}
+
+//Appends the index of every fleet in a cell touching the circle to out
+void FleetGrid::query(Vec2f center, float radius, std::vector<unsigned int>& out) const
+{
+  if (columns_ == 0) return;
+
+  //Skip circles that miss the grid entirely
+  if (center.x() + radius < left_ || center.y() + radius < top_ ||
+      center.x() - radius > left_ + columns_ * cellSize_ ||
+      center.y() - radius > top_ + rows_ * cellSize_) return;
+
+  int c1 = column(center.x() - radius);
+  int c2 = column(center.x() + radius);
+  int r1 = row(center.y() - radius);
+  int r2 = row(center.y() + radius);
+
+  for (int r = r1; r <= r2; r++)
+    {
+      //Cells in a row are adjacent in fleets_, so copy the whole span at once
+      int first = start_[r * columns_ + c1];
+      int last = start_[r * columns_ + c2 + 1];
+      out.insert(out.end(), fleets_.begin() + first, fleets_.begin() + last);
+    }
+}
+
+//Finds the column containing an x coordinate, clamped to the grid
+int FleetGrid::column(double x) const
+{
+  int c = int((x - left_) / cellSize_);
+  if (c < 0) return 0;
+  if (c >= columns_) return columns_ - 1;
+  return c;
+}
+
+//Finds the row containing a y coordinate, clamped to the grid
+int FleetGrid::row(double y) const
+{
+  int r = int((y - top_) / cellSize_);
+  if (r < 0) return 0;
+  if (r >= rows_) return rows_ - 1;
+  return r;
+}
+
+#endif
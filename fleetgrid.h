@@ -0,0 +1,62 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----FleetGrid Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  A uniform grid over fleet positions, used to quickly find the fleets near a
+  point without checking every fleet in the world. The grid is rebuilt from
+  scratch each step, and stores its cells packed into one array so building it
+  does not allocate once it has grown to size.
+*/
+
+#ifndef _fleetgrid_h_
+#define _fleetgrid_h_
+
+#include <vector>
+#include "fleetstore.h"
+#include "vec2f.h"
+
+class FleetGrid
+{
+ public:
+  //Constructors
+  FleetGrid();
+
+  //Sorts the fleets into cells of the given size
+  //The grid holds packed indices, so it is only valid until the store changes
+  void build(const FleetStore& fleets, float cellSize);
+
+  //Appends the index of every fleet in a cell touching the circle to out
+  //Fleets further than radius away may be included
+  void query(Vec2f center, float radius, std::vector<unsigned int>& out) const;
+
+  //Accessors
+  float cellSize() const {return cellSize_;}
+
+ private:
+  //Finds the column or row containing a coordinate, clamped to the grid
+  int column(double x) const;
+  int row(double y) const;
+
+  //The side length of each cell
+  float cellSize_;
+
+  //The location of the top left corner of the grid
+  double left_;
+  double top_;
+
+  //The number of cells in each direction
+  int columns_;
+  int rows_;
+
+  //Where each cell's fleets begin in fleets_, with one extra entry at the end
+  std::vector<int> start_;
+
+  //The indices of all fleets, sorted by cell
+  std::vector<unsigned int> fleets_;
+};
+
+#endif
@@ -0,0 +1,40 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----FleetId Struct-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Contains the FleetId struct for "Galcon", a handle to a fleet in a FleetStore.
+  A handle names a slot and the generation of that slot when the fleet was
+  added, so a handle to a destroyed fleet is detected instead of dangling.
+*/
+
+#ifndef _fleetid_h_
+#define _fleetid_h_
+
+struct FleetId
+{
+  //Which slot in the store holds the fleet
+  unsigned int index;
+
+  //The slot's generation when the fleet was added
+  //Generations start at 1, so 0 never refers to a live fleet
+  unsigned int generation;
+};
+
+//A handle that never refers to a fleet
+const FleetId NO_FLEET = {0, 0};
+
+inline bool operator==(const FleetId& a, const FleetId& b)
+{
+  return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator!=(const FleetId& a, const FleetId& b)
+{
+  return !(a == b);
+}
+
+#endif
@@ -0,0 +1,273 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----FleetStore Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the FleetStore class.
+*/
+
+#ifndef _fleetstore_cpp_
+#define _fleetstore_cpp_
+
+#include "fleetstore.h"
+#include "fleet.h"
+
+//Default constructor, the store starts out empty
+FleetStore::FleetStore()
+{}
+
+//Launches a fleet from begin to end, returning its handle
+FleetId FleetStore::add(int ships, int type, const ShipStats& shipstats, Planet* begin, Planet* end)
+{
+  //Reuse a free slot if there is one
+  unsigned int s;
+  if (!free_.empty())
+    {
+      s = free_.back();
+      free_.pop_back();
+    }
+  else
+    {
+      s = slots_.size();
+      Slot fresh = {0, 1};
+      slots_.push_back(fresh);
+    }
+  slots_[s].dense = x_.size();
+
+  //Start at the center of the source planet, aimed at the center of the destination
+  float radius = UNSCALED_PLANET_RADIUS * end->size();
+  float x = begin->x() + (UNSCALED_PLANET_RADIUS * begin->size());
+  float y = begin->y() + (UNSCALED_PLANET_RADIUS * begin->size());
+  float tx = end->x() + radius;
+  float ty = end->y() + radius;
+  Vec2f dir(tx - x, ty - y);
+  dir.normalize();
+
+  x_.push_back(x);
+  y_.push_back(y);
+  dx_.push_back(dir.x());
+  dy_.push_back(dir.y());
+  tx_.push_back(tx);
+  ty_.push_back(ty);
+  arriveSq_.push_back(radius * radius);
+  speed_.push_back(shipstats.speed);
+  ships_.push_back(ships);
+  type_.push_back(type);
+  owner_.push_back(begin->owner());
+  dest_.push_back(end);
+  interceptTime_.push_back(shipstats.interceptCD);
+  damage_.push_back(0);
+  slotOf_.push_back(s);
+
+  //Let the destination know what is coming
+  end->addIncoming(owner_.back(), type, ships);
+
+  FleetId id = {s, slots_[s].generation};
+  return id;
+}
+
+//Removes the fleet with the given handle, if it still exists
+void FleetStore::remove(FleetId id)
+{
+  if (!alive(id)) return;
+
+  //The fleet is no longer headed anywhere
+  unsigned int d = slots_[id.index].dense;
+  dest_[d]->addIncoming(owner_[d], type_[d], -ships_[d]);
+
+  //Move the last fleet into the hole
+  unsigned int last = x_.size() - 1;
+  if (d != last)
+    {
+      x_[d] = x_[last];
+      y_[d] = y_[last];
+      dx_[d] = dx_[last];
+      dy_[d] = dy_[last];
+      tx_[d] = tx_[last];
+      ty_[d] = ty_[last];
+      arriveSq_[d] = arriveSq_[last];
+      speed_[d] = speed_[last];
+      ships_[d] = ships_[last];
+      type_[d] = type_[last];
+      owner_[d] = owner_[last];
+      dest_[d] = dest_[last];
+      interceptTime_[d] = interceptTime_[last];
+      damage_[d] = damage_[last];
+      slotOf_[d] = slotOf_[last];
+      slots_[slotOf_[d]].dense = d;
+    }
+  x_.pop_back();
+  y_.pop_back();
+  dx_.pop_back();
+  dy_.pop_back();
+  tx_.pop_back();
+  ty_.pop_back();
+  arriveSq_.pop_back();
+  speed_.pop_back();
+  ships_.pop_back();
+  type_.pop_back();
+  owner_.pop_back();
+  dest_.pop_back();
+  interceptTime_.pop_back();
+  damage_.pop_back();
+  slotOf_.pop_back();
+
+  //Retire the slot so old handles stop matching
+  slots_[id.index].generation++;
+  if (slots_[id.index].generation == 0) slots_[id.index].generation = 1;
+  free_.push_back(id.index);
+}
+
+//Finds the packed index of the fleet with the given handle, or -1 if it no longer exists
+int FleetStore::find(FleetId id) const
+{
+  if (!alive(id)) return -1;
+  return slots_[id.index].dense;
+}
+
+//Checks whether the handle still refers to a fleet
+bool FleetStore::alive(FleetId id) const
+{
+  //Freeing a slot changes its generation, so a match means the fleet is live
+  return id.index < slots_.size() && id.generation == slots_[id.index].generation;
+}
+
+//Returns a view of the fleet at a packed index
+Fleet FleetStore::operator[](unsigned int i)
+{
+  return Fleet(this, i);
+}
+
+//Returns the total attack power of a fleet
+float FleetStore::totalAttack(unsigned int i, const std::vector<ShipStats> & shipstats) const
+{
+  return float(ships_[i]) * shipstats[type_[i]].attack;
+}
+
+//Returns the total defense of a fleet
+float FleetStore::totalDefense(unsigned int i, const std::vector<ShipStats> & shipstats) const
+{
+  return float(ships_[i]) * shipstats[type_[i]].defense;
+}
+
+//Moves every fleet and counts down interception cooldowns
+//Appends the handles of fleets that reached their destination to arrived
+void FleetStore::updateAll(const SimClock& clock, std::vector<FleetId>& arrived)
+{
+  unsigned int n = x_.size();
+  if (n == 0) return;
+
+  //Count down to the next interception shot
+  int dt = clock.dt();
+  int* cd = &interceptTime_[0];
+  for (unsigned int i = 0; i < n; i++)
+    {
+      cd[i] = (cd[i] > dt) ? cd[i] - dt : 0;
+    }
+
+  //Move every fleet towards its destination, remembering the direction
+  //Fleets are handled four at a time, with the leftovers done one by one
+  float seconds = clock.seconds();
+  unsigned int i = 0;
+  for (; i + Vec2x4::WIDTH <= n; i += Vec2x4::WIDTH)
+    {
+      Vec2x4 pos, dir, step;
+      pos.load(&x_[i], &y_[i]);
+      dir.load(&tx_[i], &ty_[i]);
+      dir -= pos;
+      dir.normalize();
+      dir.store(&dx_[i], &dy_[i]);
+
+      step = dir;
+      step.scale(&speed_[i]);
+      step *= seconds;
+      pos += step;
+      pos.store(&x_[i], &y_[i]);
+
+      //Check for arrival, when the distance from the center is less than the planet radius
+      Vec2x4 left;
+      left.load(&tx_[i], &ty_[i]);
+      left -= pos;
+      float distSq[Vec2x4::WIDTH];
+      left.lengthSq(distSq);
+      for (int k = 0; k < Vec2x4::WIDTH; k++)
+	{
+	  if (distSq[k] < arriveSq_[i+k]) arrived.push_back(id(i+k));
+	}
+    }
+  for (; i < n; i++)
+    {
+      Vec2f pos(x_[i], y_[i]);
+      Vec2f tar(tx_[i], ty_[i]);
+      Vec2f dir = tar - pos;
+      dir.normalize();
+      pos += dir * (speed_[i] * seconds);
+      x_[i] = pos.x();
+      y_[i] = pos.y();
+      dx_[i] = dir.x();
+      dy_[i] = dir.y();
+      if (pos.distanceSq(tar) < arriveSq_[i]) arrived.push_back(id(i));
+    }
+}
+
+//Applies damage to a fleet
+//Returns false if this hit would destroy the fleet
+bool FleetStore::takeHit(unsigned int i, int damage, const std::vector<ShipStats> & shipstats)
+{
+  //Add in any extra damage from last time
+  damage += damage_[i];
+
+  //Convert damage to ship loss
+  int shiploss = damage / shipstats[type_[i]].defense;
+
+  //If we can wipe out the whole fleet
+  if (shiploss >= ships_[i]) return false;
+
+  //Otherwise, deal some damage
+  ships_[i] -= shiploss;
+  dest_[i]->addIncoming(owner_[i], type_[i], -shiploss);
+
+  //Keep track of any extra accumulated damage
+  damage_[i] = damage % int(shipstats[type_[i]].defense);
+  return true;
+}
+
+//Attempts to have fleet i intercept the target fleet. Returns 0 if nothing happens
+//Returns 1 if the fleets are properly placed for interception, but the attack is on CD
+//Returns 2 and damages the target fleet if successful
+//Returns 3 instead if the target fleet is destroyed because of it
+char FleetStore::intercept(unsigned int i, unsigned int target, const std::vector<ShipStats> & shipstats)
+{
+  //Don't compare against itself
+  if (i == target) return 0;
+
+  //Can't intercept your own ships
+  if (owner_[i] == owner_[target]) return 0;
+
+  //Target must be within interception range
+  Vec2f diff = pos(target) - pos(i);
+  if (!diff.withinRange(shipstats[type_[i]].interceptRange)) return 0;
+
+  //Ensure we are appropriately behind the target
+  //The angle between diff and the target's heading must be at most PI/3
+  if (!diff.angleWithin(vel(target), 0.5f)) return 0;
+
+  //Ensure we are facing the defender
+  //The angle between diff and our heading must be at most PI/4
+  if (!diff.angleWithin(vel(i), float(M_SQRT1_2))) return 0;
+
+  //Now, we know we're in place to intercept
+  //If we can't fire a shot now, end here
+  if (interceptTime_[i] > 0) return 1;
+
+  //Wait a full cooldown before the next shot
+  interceptTime_[i] = shipstats[type_[i]].interceptCD;
+
+  //Deal damage to the target and return
+  return (takeHit(target, shipstats[type_[i]].interceptDamage*ships_[i], shipstats))?2:3;
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----FleetStore Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Holds every fleet in the world. Each property of the fleets is kept in its
+  own packed array, so the per-step movement is one tight loop over plain
+  floats. Fleets are reached from outside through FleetId handles, and looking
+  up, checking and removing a fleet by handle are all constant time.
+
+  Removing a fleet moves the last fleet into its place, so indices and Fleet
+  views are only valid until the store changes. Handles stay valid.
+*/
+
+#ifndef _fleetstore_h_
+#define _fleetstore_h_
+
+#include <vector>
+#include "SDL/SDL.h"
+#include "planet.h"
+#include "shipstats.h"
+#include "simclock.h"
+#include "vec2f.h"
+#include "fleetid.h"
+
+class Fleet;
+
+class FleetStore
+{
+ public:
+  //Constructors
+  FleetStore();
+
+  //Launches a fleet from begin to end, returning its handle
+  //The store keeps each destination's count of incoming ships up to date
+  FleetId add(int ships, int type, const ShipStats& shipstats, Planet* begin, Planet* end);
+
+  //Removes the fleet with the given handle, if it still exists
+  void remove(FleetId id);
+
+  //Finds the packed index of the fleet with the given handle, or -1 if it no longer exists
+  int find(FleetId id) const;
+  bool alive(FleetId id) const;
+
+  //Access to the packed fleets, from 0 to size()-1
+  unsigned int size() const {return x_.size();}
+  bool empty() const {return x_.empty();}
+  Fleet operator[](unsigned int i);
+
+  //Accessors for the fleet at a packed index
+  Vec2f pos(unsigned int i) const {return Vec2f(x_[i], y_[i]);}
+  float x(unsigned int i) const {return x_[i];}
+  float y(unsigned int i) const {return y_[i];}
+  Vec2f vel(unsigned int i) const {return Vec2f(dx_[i], dy_[i]);}
+  float speed(unsigned int i) const {return speed_[i];}
+  int ships(unsigned int i) const {return ships_[i];}
+  int type(unsigned int i) const {return type_[i];}
+  Planet* dest(unsigned int i) const {return dest_[i];}
+  int owner(unsigned int i) const {return owner_[i];}
+  FleetId id(unsigned int i) const {FleetId ret = {slotOf_[i], slots_[slotOf_[i]].generation}; return ret;}
+  float totalAttack(unsigned int i, const std::vector<ShipStats> & shipstats) const;
+  float totalDefense(unsigned int i, const std::vector<ShipStats> & shipstats) const;
+
+  //Moves every fleet and counts down interception cooldowns
+  //Appends the handles of fleets that reached their destination to arrived
+  void updateAll(const SimClock& clock, std::vector<FleetId>& arrived);
+
+  //Fleet interactions, by packed index
+  bool takeHit(unsigned int i, int damage, const std::vector<ShipStats> & shipstats);
+  char intercept(unsigned int i, unsigned int target, const std::vector<ShipStats> & shipstats);
+
+ private:
+  struct Slot
+  {
+    //Position of the fleet in the packed arrays, if the slot is in use
+    unsigned int dense;
+
+    //Incremented every time the slot is freed
+    unsigned int generation;
+  };
+
+  //Current coordinates
+  std::vector<float> x_;
+  std::vector<float> y_;
+
+  //Unit vector in the direction of travel, updated as the fleet moves
+  std::vector<float> dx_;
+  std::vector<float> dy_;
+
+  //Center of the destination planet, and the squared radius that counts as arrival
+  //Planets never move, so these are found once at launch
+  std::vector<float> tx_;
+  std::vector<float> ty_;
+  std::vector<float> arriveSq_;
+
+  //The speed, in pixels/second
+  std::vector<float> speed_;
+
+  //Ship count, ship type and owner
+  std::vector<int> ships_;
+  std::vector<int> type_;
+  std::vector<int> owner_;
+
+  //Destination planet
+  std::vector<Planet*> dest_;
+
+  //The time remaining, in milliseconds, until another interception shot can be fired
+  std::vector<int> interceptTime_;
+
+  //Accumulated, yet unapplied, damage
+  std::vector<int> damage_;
+
+  //The slot of each packed fleet
+  std::vector<unsigned int> slotOf_;
+
+  //Every slot ever handed out, and the ones currently unused
+  std::vector<Slot> slots_;
+  std::vector<unsigned int> free_;
+};
+
+#endif
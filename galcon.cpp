@@ -9,28 +9,33 @@
   Contains the main body for the game "Galcon" (Unnamed so far).
 */
 
-#include "planet.h"
-#include "fleet.h"
-#include "projectile.h"
+#include "world.h"
 #include "vec2f.h"
-#include "ai.h"
-#include "lineDrawer.h"
+#include "renderer.h"
+#include "dirtyrects.h"
+#include "glyphatlas.h"
+#include "rotationregistry.h"
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
 #include <list>
 #include <cmath>
-#include <sstream>
 #include <ctime>
 #include <cstdlib>
+#include <iostream>
 
 const int SCREEN_WIDTH = 1000;
 const int SCREEN_HEIGHT = 750;
-const int LEVEL_WIDTH = 1000;
-const int LEVEL_HEIGHT = 750;
 const int CAMERA_SPEED = 400;
 const int FPS_CAP = 60;
 
+//How far past the camera the world is recorded, so the camera can keep moving
+//for as long as the simulation might go without a step
+const int RECORD_MARGIN = CAMERA_SPEED * SIM_MAX_CATCHUP / 1000;
+
+//Where finished rotation caches are saved, so later runs can skip rotating
+const char* ROTATION_ATLAS_DIR = "cache";
+
 SDL_Surface* loadImage(std::string filename)
 {
   //The image that's loaded
@@ -137,163 +142,74 @@ int main(int argc, char* argv[])
   shipstats[2].defense = 1;
   shipstats[2].speed = DEFAULT_FLEET_SPEED*1.25;
 
+  //The array of indicators
+  SDL_Surface* indicator[3];
+  indicator[0] = NULL;
+  indicator[1] = loadImage("selectorb.png");
+  indicator[2] = loadImage("selectorr.png");
+
+  //The planet images
+  SDL_Surface* planetImg[NUM_PLANET_IMAGES];
+  planetImg[PLANET_IMAGE_NORMAL] = loadImage("planet0.png");
+  planetImg[PLANET_IMAGE_LAVA] = loadImage("planet1.png");
+  planetImg[PLANET_IMAGE_DEPLETED] = loadImage("planet1-1.png");
+
+  //Keep finished rotations on disk between runs
+  RotationRegistry::shared().setAtlasDirectory(ROTATION_ATLAS_DIR);
+
+  //Create the world
+  GameWorld world(shipstats, planetImg, indicator);
+
   //Set up buildings and building rules
-  std::list<Building> buildings;
-  std::vector<std::list<Building*> > buildRules;
-  buildRules.resize(2);
   SDL_Surface* b01 = loadImage("b01.png");
   SDL_Surface* bc01 = loadImage("bc01.png");
   SDL_Surface* b02 = loadImage("b02.png");
   SDL_Surface* bc02 = loadImage("bc02.png");
-  buildings.push_back(Building(b01, bc01, "build 0 2")); //0
-  buildings.push_back(Building(b02, bc02, "fire damage 2 1")); //1
-  buildings.push_back(Building(b01, bc01, "build 1 4")); //2
-  buildings.push_back(Building(b01, bc01, "build 2 2")); //3
-  buildings.push_back(Building(b02, bc02, "aura damage 1 total")); //4
 
   //0
-  std::list<Building>::iterator bi = buildings.begin();
-  buildRules[0].push_back(&(*bi));
-  bi->setBuildTime(15000);
-  bi++;
+  Building* b = world.addBuilding(Building(b01, bc01, "build 0 2"), 0);
+  b->setBuildTime(15000);
 
   //1
-  buildRules[0].push_back(&(*bi));
-  bi->setBuildTime(10000);
-  bi->setRange(250);
-  bi++;
+  b = world.addBuilding(Building(b02, bc02, "fire damage 2 1"), 0);
+  b->setBuildTime(10000);
+  b->setRange(250);
 
   //2
-  buildRules[0].push_back(&(*bi));
-  bi->setBuildTime(15000);
-  bi++;
+  b = world.addBuilding(Building(b01, bc01, "build 1 4"), 0);
+  b->setBuildTime(15000);
 
   //3
-  buildRules[1].push_back(&(*bi));
-  bi->setBuildTime(15000);
-  bi++;
+  b = world.addBuilding(Building(b01, bc01, "build 2 2"), 1);
+  b->setBuildTime(15000);
 
   //4
-  buildRules[1].push_back(&(*bi));
-  bi->setBuildTime(10000);
-  bi->setRange(200);
-  bi->setCD(1000);
-
-  //Building images are now in rotation caches
-  SDL_FreeSurface(b01);
-  SDL_FreeSurface(bc01);
-  SDL_FreeSurface(b02);
-  SDL_FreeSurface(bc02);
-
-  //Create a list of planets
-  std::list<Planet> planets;
-
-  //The standard rate of production of basic ship 0
-  float ship0rate = 1.0;
-
-  //The array of indicators
-  SDL_Surface* indicator[3];
-  indicator[1] = loadImage("selectorb.png");
-  indicator[2] = loadImage("selectorr.png");
-  
-  SDL_Surface* planet0img = loadImage("planet0.png");
-  SDL_Surface* planet1img = loadImage("planet1.png");
-  SDL_Surface* planet1_1img = loadImage("planet1-1.png");
-
-  //Create the planets at random
-  //First, create two home planets
-  std::vector<int> homestart;
-  homestart.resize(1,3);
-  planets.push_back(Planet(planet0img, 1.0,
-			   Vec2f(rand()%100, 100 + rand()%(LEVEL_HEIGHT-200)), 0));
-  planets.back().setOwner(1, indicator);
-  planets.back().setShipRate(0, ship0rate);
-  planets.back().setRotSpeed(M_PI/20);
-  planets.back().addShips(3, 0);
-  planets.push_back(Planet(planet0img, 1.0,
-			   Vec2f(LEVEL_WIDTH-(2*UNSCALED_PLANET_RADIUS)-(rand()%100),
-				 100 + rand()%(LEVEL_HEIGHT-200)), 0));
-  planets.back().setOwner(2, indicator);
-  planets.back().setShipRate(0, ship0rate);
-  planets.back().setRotSpeed(M_PI/20);
-  planets.back().addShips(3, 0);
-
-  //Now repeatedly create planets until either a target density is reached
-  //or we go too many tries without finding a spot for a new planet.
-  char tries = 0;
-  char maxTries = 10;
-  double density = 0.13;
-  double totalSize = LEVEL_WIDTH*LEVEL_HEIGHT;
-  double currentSize = M_PI*UNSCALED_PLANET_RADIUS*UNSCALED_PLANET_RADIUS*2;
-  double spacing = 23;
-  
-  while (currentSize/totalSize < density && tries < maxTries)
+  b = world.addBuilding(Building(b02, bc02, "aura damage 1 total"), 1);
+  b->setBuildTime(10000);
+  b->setRange(200);
+  b->setCD(1000);
+
+  //Create the planets at random, with the standard rate of production of
+  //basic ship 0
+  world.generate(1.0);
+
+  //Start rotating the planet and building images in the background
+  //The world never draws, so this is left to the game
+  for (std::list<Planet>::iterator i = world.planets().begin(); i != world.planets().end(); i++)
+    {
+      i->precache();
+    }
+  for (unsigned int type = 0; type < world.buildRules().size(); type++)
     {
-      //Create a new planet at a completely random location with a random size
-      //For now, make half normal and half volcanic
-      float psize = (double(rand())/double(RAND_MAX))*0.7 + 0.5;
-      Planet p(planet0img, psize,
-               Vec2f(rand()%(LEVEL_WIDTH-int(2*UNSCALED_PLANET_RADIUS*psize)),
-                     rand()%(LEVEL_HEIGHT-int(2*UNSCALED_PLANET_RADIUS*psize))), 0);;
-      if (rand()%2 == 0)
-        {
-          p.setType(0);
-          p.setImage(planet0img);
-        }
-      else
-        {
-          p.setType(1);
-          p.setImage(planet1img);
-        }
-
-      //Make sure it doesn't collide with any other planets
-      bool skip = false;
-      for (planetIter pi = planets.begin(); pi != planets.end(); pi++)
+      const std::list<Building*>& rules = world.buildRules()[type];
+      for (std::list<Building*>::const_iterator i = rules.begin(); i != rules.end(); i++)
 	{
-	  Vec2f ppos = p.pos()+Vec2f(UNSCALED_PLANET_RADIUS*p.size(),UNSCALED_PLANET_RADIUS*p.size());
-	  Vec2f pipos = pi->pos()+Vec2f(UNSCALED_PLANET_RADIUS*pi->size(),UNSCALED_PLANET_RADIUS*pi->size());
-	  if ((pipos-ppos).length() <
-	      p.size()*UNSCALED_PLANET_RADIUS +
-	      pi->size()*UNSCALED_PLANET_RADIUS + spacing)
-	    {
-	      //There's a collision. Increment tries and try again
-	      tries++;
-	      skip = true;
-	      break;
-	    }
+	  (*i)->precache();
 	}
-      if (skip) continue;
-
-      //At this point, we know there's no collision. Reset tries
-      tries = 0;
-
-      //Add a few more random attributes
-      p.setOwner(0, indicator);
-      p.setShipRate(0, ship0rate);
-      p.setRotSpeed((fmod(rand(),M_PI)/5) - M_PI/10);
-      p.setDifficulty(p.size()*20 + rand()%15 - 9);
-
-      //Add this planet to the current size
-      currentSize += M_PI*(UNSCALED_PLANET_RADIUS*p.size())*(UNSCALED_PLANET_RADIUS*p.size());
-
-      //Add it to the list
-      planets.push_back(p);
     }
-  
-  //Set up fleet list
-  std::list<Fleet> fleets;
-
-  //Set up projectile list
-  std::list<Projectile> projectiles;
-
-  //Filler to act as NULL
-  planetIter planNull;
 
   //The currently selected planet
-  planetIter selectPlanet = planNull;
-
-  //Set up AI
-  std::list<GalconAI> ai;
+  Planet* selectPlanet = NULL;
 
   //For now, AI controls player 2
   GalconAISettings aiSet;
@@ -306,9 +222,7 @@ int main(int argc, char* argv[])
   aiSet.maximumBuildingFraction = .8;
   aiSet.minimumDefenseForBuilding = 10;
   aiSet.distancePower = 1.15;
-  ai.push_back(GalconAI(2, aiSet));
-  ai.begin()->init(planets, shipstats);
-  ai.begin()->activate();
+  world.addAI(2, aiSet);
 
   //The number of the locally playing player
   char localPlayer = 1;
@@ -316,8 +230,14 @@ int main(int argc, char* argv[])
   //The type of ship that will currently be sent
   int shipSendType = 0;
 
-  //A line drawer for the main surface
-  LineDrawer linedraw(screen);
+  //Draws what the world records after each step
+  Renderer renderer(screen, planetFont);
+
+  //What the world looked like after the last step
+  RenderList commands;
+
+  //Tracks what is drawn where, so only the parts that change are redrawn
+  DirtyRects dirty(SCREEN_WIDTH, SCREEN_HEIGHT);
   
   /*
     -----
@@ -326,15 +246,18 @@ int main(int argc, char* argv[])
   */
 
   int time = SDL_GetTicks();
+  int simTime = 0;
   uint8_t quit = 0;
   while (quit == 0)
     {
-      //Update time and dt
       //Cap FPS
       int dt = SDL_GetTicks() - time;
       float minms = 1000.0/float(FPS_CAP);
       if (dt < minms) SDL_Delay(minms-dt);
-      time = SDL_GetTicks();
+
+      //Update time and dt, including any time spent waiting
+      dt = SDL_GetTicks() - time;
+      time += dt;
 
       //Update keystates
       keystates = SDL_GetKeyState(NULL);
@@ -365,6 +288,8 @@ int main(int argc, char* argv[])
 	}
 
       //Update camera from camerax and cameray to struct
+      //Moving the camera moves everything, so the whole screen is redrawn
+      if (camera.x != Sint16(camerax) || camera.y != Sint16(cameray)) dirty.invalidate();
       camera.x = camerax;
       camera.y = cameray;
       
@@ -388,37 +313,14 @@ int main(int argc, char* argv[])
 		  quit = 1;
 		  break;
 		case SDLK_q:
-		  if (selectPlanet != planNull)
-                    {
-                      if (selectPlanet->owner() != localPlayer ||
-                          buildRules[selectPlanet->type()].size() < 1) break;
-                      
-                      selectPlanet->build(*(buildRules[selectPlanet->type()].begin()),
-                                          buildRules);
-                    }
+		  if (selectPlanet != NULL) world.build(selectPlanet, 0);
 		  break;
 		case SDLK_w:
-		  if (selectPlanet != planNull)
-                    {
-                      if (selectPlanet->owner() != localPlayer ||
-                          buildRules[selectPlanet->type()].size() < 2) break;
-                      
-                      selectPlanet->build(*(++buildRules[selectPlanet->type()].begin()),
-                                          buildRules);
-                    }
+		  if (selectPlanet != NULL) world.build(selectPlanet, 1);
 		  break;
 		case SDLK_e:
-		  if (selectPlanet != planNull)
-                    {
-                      if (selectPlanet->owner() != localPlayer ||
-                          buildRules[selectPlanet->type()].size() < 3) break;
-                      
-                      std::list<Building*>::iterator i;
-                      i = buildRules[selectPlanet->type()].begin();
-                      i++; i++;
-                      selectPlanet->build(*i, buildRules);
-                    }
-                  break;
+		  if (selectPlanet != NULL) world.build(selectPlanet, 2);
+		  break;
 		case SDLK_1:
 		  shipSendType = 0;
 		  break;
@@ -442,31 +344,19 @@ int main(int argc, char* argv[])
 	  //Check for mouse clicks
 	  if (event.type == SDL_MOUSEBUTTONDOWN)
 	    {
+	      //Adjust mouse coordinates based on camera
+	      Vec2f click(event.button.x + camera.x, event.button.y + camera.y);
+	      Planet* clicked = world.planetAt(click);
+
 	      //Left click
 	      if (event.button.button == SDL_BUTTON_LEFT)
 		{
 		  //Used to select a planet
-		  //Check if any are being clicked on
-		  selectPlanet = planNull;
-
-		  //Adjust mouse coordinates based on camera
-		  Vec2f click(event.button.x + camera.x, event.button.y + camera.y);
-		  
-		  for (planetIter i = planets.begin(); i != planets.end(); i++)
+		  //Ensure the planet belongs to this person
+		  selectPlanet = NULL;
+		  if (clicked != NULL && clicked->owner() == localPlayer)
 		    {
-		      //See if distance from center is less than planet radius
-		      Vec2f center(i->x() + (UNSCALED_PLANET_RADIUS * i->size()),
-				   i->y() + (UNSCALED_PLANET_RADIUS * i->size()));
-
-		      if ((click-center).length() < UNSCALED_PLANET_RADIUS * i->size())
-			{
-			  //Ensure the planet belongs to this person
-			  if ((*i).owner() == localPlayer)
-			    {
-			      selectPlanet = i;
-			      break;
-			    }
-			}
+		      selectPlanet = clicked;
 		    }
 		}
 
@@ -475,527 +365,72 @@ int main(int argc, char* argv[])
 		{
 		  //Used to choose the destination for a fleet
 		  //See if we have a selected planet
-		  if (selectPlanet != planNull)
+		  if (selectPlanet != NULL && clicked != NULL)
 		    {
-
-		      //Adjust mouse coordinates based on camera
-		      Vec2f click(event.button.x + camera.x, event.button.y + camera.y);
-		      
-		      //Check to see if any are being clicked on
-		      for (planetIter i = planets.begin(); i != planets.end(); i++)
-			{
-			  Vec2f center(i->x() + (UNSCALED_PLANET_RADIUS * i->size()),
-				       i->y() + (UNSCALED_PLANET_RADIUS * i->size()));
-			  
-			  //See if distance from center is less than planet radius
-			  if ((click-center).length() < UNSCALED_PLANET_RADIUS * i->size())
-			    {
-			      //Split ships from the source planet
-			      int transfer = (*selectPlanet).splitShips(0.5, shipSendType);
-			      //Make sure we actually have a ship in the fleet
-			      if (transfer > 0)
-				{
-				  //Add the new fleet
-				  fleets.push_back(Fleet(transfer, shipSendType, shipstats[shipSendType], &(*selectPlanet), &(*i)));
-				  break;
-				}
-			    }
-			}
+		      world.sendFleet(selectPlanet, clicked, 0.5, shipSendType);
 		    }
 		}
 	    }
 	}
 
-      //Draw a white background
-      SDL_Rect back = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-      SDL_FillRect(screen, &back, 0xFFFFFF);
-
-      //Update and display fleets
-      for (fleetIter i = fleets.begin(); i != fleets.end(); i++)
+      //Advance the simulation in fixed steps to catch up with real time
+      simTime += dt;
+      if (simTime > SIM_MAX_CATCHUP) simTime = SIM_MAX_CATCHUP;
+      bool stepped = false;
+      while (simTime >= SIM_STEP)
 	{
-	  (*i).update();
-
-	  //Check for arrival at destination
-	  //See if distance from center is less than planet radius
-	  Vec2f tar((*i).dest()->x() + (UNSCALED_PLANET_RADIUS*(*i).dest()->size()),
-		    (*i).dest()->y() + (UNSCALED_PLANET_RADIUS*(*i).dest()->size()));
-	  
-	  if ((tar-i->pos()).length() < UNSCALED_PLANET_RADIUS * (i->dest())->size())
-	    {
-	      //Check if friendly or hostile
-	      if ((*i).dest()->owner() == (*i).owner())
-		{
-		  //Add the fleet to the new planet
-		  (*((*i).dest())).addShips(i->ships(), i->type());
-		}
-	      else //Hostile
-		{
-		  //Attack!
-		  //Get ship counts before the attack
-		  std::vector<int> ships1 = i->dest()->shipcount();
-		  int oldowner = i->dest()->owner();
-
-		  //Actually do the attack
-		  (*((*i).dest())).takeAttack(i->ships(), i->type(), i->owner(), shipstats, indicator);
-
-		  //If the attack changed ownership of the selected planet,
-		  //deselect it
-		  if (oldowner != i->dest()->owner() && i->dest() == &(*selectPlanet)) selectPlanet = planNull;
-
-		  //Get ship counts after the attack
-		  std::vector<int> ships2 = i->dest()->shipcount();
-
-		  //Notify the defending AI about the losses
-		  for (std::list<GalconAI>::iterator j = ai.begin(); j != ai.end(); j++)
-		    {
-		      if (oldowner != j->player()) continue;
-		      float newdefense = 0;
-		      for (unsigned int k = 0; k < ships1.size(); k++)
-			{
-			  int diff;
-			  //If ownership has changed
-			  if (oldowner != i->dest()->owner())
-			    {
-			      diff = ships1[k];
-			      j->notifyPlanetLoss(i->dest());
-			    }
-			  else
-			    {
-			      diff = ships1[k] - ships2[k];
-			    }
-			  
-			  newdefense += diff * shipstats[k].defense;
-			}
-		      j->notifyDefendLoss(newdefense);
-		    }
-
-		  //Notify the attacking AI about the losses
-		  for (std::list<GalconAI>::iterator j = ai.begin(); j != ai.end(); j++)
-		    {
-		      if (i->owner() != j->player()) continue;
-		      float lost;
-		      
-		      //If the attack failed
-		      if (i->dest()->owner() != i->owner())
-			{
-			  //Lost everything
-			  lost = i->ships();
-			}
-		      else //Successful attack
-			{
-			  //Lose the difference
-			  lost = i->ships() - i->dest()->totalDefense(shipstats);
-			  j->notifyPlanetGain(i->dest());
-			}
-		      
-		      j->notifyAttackLoss(lost);
-		    }
-		}
-
-	      //Delete all projectiles with this fleet as its target
-	      for (projectileIter pi = projectiles.begin(); pi != projectiles.end(); pi++)
-		{
-		  if (pi->target() == &(*(i)))
-		    {
-		      pi = projectiles.erase(pi);
-		      pi--;
-		    }
-		}
-
-	      //Delete the fleet
-	      i = fleets.erase(i);
-	      i--;
-	      continue;
-	    }
-
-	  //Check for interception
-	  //Compare against every other fleet
-	  for (fleetIter j = fleets.begin(); j != fleets.end(); j++)
-	    {
-	      //Atempt interception
-	      char status = i->intercept(&(*j), shipstats);
-
-	      //Greater than 0: Draw line
-	      if (status <= 0) continue;
-	      SDL_Color red = {255, 0, 0};
-	      SDL_Color orange = {255, 255, 0};
-	      linedraw.line(i->pos(), j->pos(), orange, red);
-
-	      //Equal to 2: Dealt damage, but didn't notify
-	      if (status == 2)
-		{
-		  //Notify the AI before we go around deleting things
-		  for (std::list<GalconAI>::iterator k = ai.begin(); k != ai.end(); k++)
-		    {
-		      if (k->player() == j->owner())
-			{
-			  k->notifyFleetDamage(std::min(double(shipstats[i->type()].interceptDamage),
-							double(j->totalDefense(shipstats))));
-			}
-		    }
-		}
-
-	      //Equal to 3: Destroy target
-	      if (status != 3) break;
-
-	      //We can have the projectile code handle the cleanup later
-	      //Create a fake projectile right on top of it to deal the final blow
-	      std::stringstream convertnum;
-	      convertnum << "damage ";
-	      convertnum << shipstats[i->type()].interceptDamage*i->ships()*2;
-	      projectiles.push_back(Projectile(j->pos(), &(*j),
-					       convertnum.str(),
-					       shipstats[j->type()].speed*2));
-
-	      //Don't attack more than one ship
-	      break;
-	    }
-	  
-	  (*i).display(screen, camera);
+	  world.step(SIM_STEP);
+	  simTime -= SIM_STEP;
+	  stepped = true;
 	}
 
-      //Update and display planets
-      for (planetIter i = planets.begin(); i != planets.end(); i++)
-	{
-	  //Get ship counts before the update
-	  std::vector<int> ships1 = i->shipcount();
-
-	  //Update the planet
-	  (*i).update();
-
-	  //Get ship counts after the update
-	  std::vector<int> ships2 = i->shipcount();
-
-	  //Notify a controlling AI about the construction
-	  for (std::list<GalconAI>::iterator j = ai.begin(); j != ai.end(); j++)
-	    {
-	      if (i->owner() != j->player()) continue;
-	      float newattack = 0;
-	      float newdefense = 0;
-	      for (unsigned int k = 0; k < ships1.size(); k++)
-		{
-		  int diff = ships2[k] - ships1[k];
-		  newattack += diff * shipstats[k].attack;
-		  newdefense += diff * shipstats[k].defense;
-		}
-	      j->notifyConstruction(newattack, newdefense);
-	    }
-
-	  //If this planet is selected, add an indicator
-	  if (i == selectPlanet)
-	    {
-	      SDL_Rect temprect = {Sint16((*i).x()-10 - camera.x), Sint16((*i).y()-10 - camera.y), Uint16(UNSCALED_PLANET_RADIUS * (*i).size() * 2 + 20), Uint16(UNSCALED_PLANET_RADIUS * (*i).size() * 2 + 20)};
-	      SDL_FillRect(screen, &temprect, SDL_MapRGB(screen->format, 100, 100, 100));
-	    }
-
-          //If this is a lava planet and it is depleted, replace the image
-          if (i->typeInfo() < 0 && i->type() == 1)
-            {
-              i->setImage(planet1_1img);
-              i->setTypeInfo(0);
-              i->setRotSpeed(0);
-              i->setShipRate(0, ship0rate * PLANET1_DEPLETION_PENALTY);
-            }
-
-	  //Iterate over all buildings to handle effects from buildings to other objects
-
-	  for (unsigned int j = 0; j < i->buildcount(); j++)
-	    {
-	      //Get the building
-	      BuildingInstance* b = i->building(j);
-	      
-	      //Skip over nonexistant and incomplete buildings
-	      if (!(b->exists()) || j == Uint32(i->buildIndex())) continue;
-
-	      //Try to make it fire, remember result
-	      bool fire = b->fire();
-	      
-	      //Create a string stream and vector for tokens
-	      std::stringstream ss(b->effect());
-	      std::string item;
-	      std::vector<std::string> tokens;
-	      while (std::getline(ss, item, ' '))
-		{
-		  tokens.push_back(item);
-		}
-	      
-	      //Ensure the size is at least two
-	      if (tokens.size() < 3) continue;
-	      
-	      //Parse it and apply effects that involve multiple objects
-	      //Fire projectile: fire <effect> <effectvars> <speed as multiplier>
-	      if (tokens[0] == "fire")
-		{
-		  //Ensure size of four
-		  if (tokens.size() != 4) continue;
-		  
-		  //Loop over all potential target fleets, find closest
-		  Fleet* closest = NULL;
-		  float closestDist = -1;
-		  Vec2f coords = i->buildcoords(j);
-		  for (fleetIter k = fleets.begin(); k != fleets.end(); k++)
-		    {
-		      //Only check further if it's an enemy fleet
-		      if (k->owner() == i->owner()) continue;
-		      //Compute the distance between them
-		      double dist = (coords-k->pos()).length();
-		      
-		      //Continue if the fleet is out of range
-		      if (dist > b->range()) continue;
-		      
-		      //Compare with previous best
-		      if (dist < closestDist || closestDist < -0.5)
-			{
-			  closestDist = dist;
-			  closest = &(*k);
-			}
-		    }
-		  
-		  //Fire a projectile from the building to the fleet
-		  if (closest != NULL)
-		    {
-		      if (fire)
-			{
-			  //Create a proper string for the projectile
-			  std::string projstr;
-			  for (unsigned int word = 1; word < tokens.size()-1; word++)
-			    { projstr += tokens[word] + " "; }
-			  projectiles.push_back(Projectile(coords, closest, projstr, std::atof(tokens[tokens.size()-1].c_str())));
-			}
-		    }
-		}
-
-              //Aura: aura <effect> <effectvars>
-              if (tokens[0] == "aura")
-                {
-                  //Find number of ships in range
-                  int shipcount = 0;
-                  for (fleetIter k = fleets.begin(); k != fleets.end(); k++)
-		    {
-		      //Only check further if it's an enemy fleet
-		      if (k->owner() == i->owner()) continue;
-		      //Compute the distance between them
-		      double dist = (i->buildcoords(j)-k->pos()).length();
-                      if (dist <= b->range()) shipcount += k->ships();
-                    }
-
-                  //Deal damage with a fake projectile
-                  if (fire)
-                    {
-                      bool hit = false;
-                      for (fleetIter k = fleets.begin(); k != fleets.end(); k++)
-                        {
-                          //Only check further if it's an enemy fleet
-                          if (k->owner() == i->owner()) continue;
-                          //Compute the distance between them
-                          double dist = (i->buildcoords(j)-k->pos()).length();
-                          if (dist > b->range()) continue;
-                          hit = true;
-                          
-                          std::string projstr;
-                          //Divide appropriately if needed
-                          if (tokens[tokens.size()-1] == "total")
-                            {
-                              std::stringstream toa;
-                              toa << atof(tokens[tokens.size()-2].c_str())*float(k->ships())/float(shipcount);
-                              tokens[tokens.size()-1] = toa.str();
-                            }
-                          //Depleted volcanic planets don't do as much
-                          if (i->type() == 1 && i->typeInfo() <= 0)
-                            {
-                              std::stringstream toa;
-                              toa << atof(tokens[tokens.size()-2].c_str())*PLANET1_DEPLETION_PENALTY;
-                              tokens[tokens.size()-1] = toa.str();
-                            }
-                          //Create the projectile
-                          for (unsigned int word = 1; word < tokens.size()-1; word++)
-                            {
-                              projstr += tokens[word] + " ";
-                            }
-                          projectiles.push_back(Projectile(k->pos(), &(*k), projstr, 1));
-                        }
-
-                      //Volcanic planets will lost some fuel
-                      if (i->type() == 1 && hit && i->typeInfo() != 0)
-                        {
-                          i->setTypeInfo(i->typeInfo()-PLANET1_DEPLETION_RATE);
-                          if (i->typeInfo() == 0) i->setTypeInfo(-1);
-                        }
-                      
-                    }
-                }
-                      
-	    } //for each building
-
-	  (*i).display(screen, planetFont, camera);
-	}
+      //If the selected planet was lost, deselect it
+      if (selectPlanet != NULL && selectPlanet->owner() != localPlayer) selectPlanet = NULL;
 
-      //Update and display projectiles
-      for (projectileIter i = projectiles.begin(); i != projectiles.end(); i++)
+      //Record the world once per frame that stepped, rather than once per step
+      if (stepped)
 	{
-	  (*i).update();
-
-	  //Check if the projectile has hit its target fleet
-	  if ((i->pos() - i->target()->pos()).length() < 12.345) //MAGIC NUMBER >:(
-	    {
-	      //Tokenize string to determine effect
-	      std::stringstream ss(i->effect());
-	      std::string item;
-	      std::vector<std::string> tokens;
-	      while (std::getline(ss, item, ' '))
-		{
-		  tokens.push_back(item);
-		}
-
-	      //Damage: damage <amount>
-	      if (tokens[0] == "damage")
-		{
-		  //Ensure size of two
-		  if (tokens.size() != 2) continue;
-
-		  //Deliver the damage
-
-		  //Notify the AI before we go around deleting things
-		  for (std::list<GalconAI>::iterator j = ai.begin(); j != ai.end(); j++)
-		    {
-		      if (j->player() == i->target()->owner())
-			{
-			  j->notifyFleetDamage(std::min(std::atof(tokens[1].c_str()), double(i->target()->totalDefense(shipstats))));
-			}
-		    }
-		  
-		  //Check to see if the fleet is destroyed by this
-		  if (!(i->target()->takeHit(std::atof(tokens[1].c_str()), shipstats)))
-		    {
-		      //Delete the fleet
-		      for (fleetIter fi = fleets.begin(); fi != fleets.end(); fi++)
-			{
-			  if (&(*fi) == &(*(i->target())))
-			    {
-			      fleets.erase(fi);
-			      break;
-			    }
-			}
-
-		      //Delete all projectiles with this fleet as the target
-		      for (projectileIter pi = projectiles.begin(); pi != projectiles.end(); pi++)
-			{
-			  if (pi->target() == i->target())
-			    {
-			      if (pi == i) continue;
-			      pi = projectiles.erase(pi);
-			      pi--;
-			    }
-			}
-
-		    }
-
-		  //Either way, destroy this projectile
-		  i = projectiles.erase(i);
-		  i--;
-		  continue;
-		}
-	    }
-
-	  (*i).display(screen, camera);
+	  SDL_Rect area = {Sint16(camera.x - RECORD_MARGIN), Sint16(camera.y - RECORD_MARGIN),
+			   Uint16(camera.w + 2*RECORD_MARGIN), Uint16(camera.h + 2*RECORD_MARGIN)};
+	  world.record(commands, area, selectPlanet);
 	}
 
-      //Perform AI calculations
-      for (std::list<GalconAI>::iterator i = ai.begin(); i != ai.end(); i++)
-	{
-	  //Get the command list
-	  commandList com = i->update(planets, fleets, shipstats, buildRules);
-
-	  //Execute each command
-	  for (commandList::iterator j = com.begin(); j != com.end(); j++)
-	    {
-	      //Extract the info from the command
-	      Planet* source = j->first;
-	      int amount = j->second.first;
-	      Planet* dest = j->second.second;
+      //Clear what was drawn last frame to the white background
+      dirty.clear(screen, 0xFFFFFF);
 
-	      //Handle building construction
-	      if (source == dest)
-		{
-		  std::list<Building*>::iterator build = buildRules[source->type()].begin();
-		  while (amount > 0)
-		    {
-		      amount--;
-		      build++;
-		    }
-
-		  //Build it!
-		  source->build((*build), buildRules);
-		  continue;
-		}
-
-	      //Get the number of ships from the source
-	      std::vector<int> ships = source->shipcount();
-
-	      //Send out a fleet for each ship type used
-	      std::vector<int> newfleet;
-	      newfleet.resize(ships.size());
-	      int total = 0;
-	      for (unsigned int k = 0; k < ships.size(); k++)
-		{
-		  //Handle it differently for attack or defense
-		  float typeTotal;
-		  if (dest->owner() == source->owner())
-		    {
-		      //Check the total defense of this ship type
-		      typeTotal = ships[k] * shipstats[k].defense;
-		    }
-		  else
-		    {
-		      //Check the total attack of this ship type
-		      typeTotal = ships[k] * shipstats[k].attack;
-		    }
-		  
-		  //If there's more ships requested than there are of this type
-		  if (total + typeTotal <= amount)
-		    {
-		      //Add them all
-		      newfleet[k] += ships[k];
-		      total += typeTotal;
-		    }
-		  else //More ships than space in the requested fleet
-		    {
-		      //Find the proper amount
-		      //# of ships to send = defense requested / def per ship
-		      float properAmount = (amount - total) / (typeTotal / ships[k]);
-		      newfleet[k] += properAmount;
-		      break;
-		    }
-		}
-	      
-	      //Fleet is built, send each type that has some ships
-	      for (unsigned int k = 0; k < newfleet.size(); k++)
-		{
-		  if (newfleet[k] == 0) continue;
-		  fleets.push_back(Fleet(newfleet[k], k, shipstats[k], source, dest));
+      //Draw the world as it was partway from the step before last to the last,
+      //so motion stays smooth however the frames and steps line up
+      renderer.draw(commands, float(simTime) / SIM_STEP, camera, dirty);
 
-		  //Also subtract the fleet from the original planet
-		  newfleet[k] *= -1;
-		  source->addShips(newfleet[k], k);
-		}
-	    }
-	}
+      //Send only the changed parts of the screen to the display
+      dirty.present(screen);
 
-      //Flipoo
-      if (SDL_Flip(screen) == -1)
-	{
-	  return 1;
-	}
+      //Save finished rotation caches and keep them within their memory budget
+      RotationRegistry::shared().update();
     }
 
+  //Report how the rotation caches did, for tuning the budget
+  RotationStats rs = RotationRegistry::shared().stats();
+  long lookups = rs.hits + rs.misses;
+  std::cout << "Rotation caches: " << rs.bytes / 1024 << " KiB held, "
+	    << (lookups > 0 ? 100 * rs.hits / lookups : 100) << "% hits, "
+	    << rs.evictions << " evictions" << std::endl;
+
   //Free surfaces
+  //The rotation registry matches images by pointer, so these are kept until now
+  SDL_FreeSurface(b01);
+  SDL_FreeSurface(bc01);
+  SDL_FreeSurface(b02);
+  SDL_FreeSurface(bc02);
   SDL_FreeSurface(indicator[1]);
   SDL_FreeSurface(indicator[2]);
-  SDL_FreeSurface(planet0img);
-  SDL_FreeSurface(planet1img);
-  SDL_FreeSurface(planet1_1img);
+  for (int i = 0; i < NUM_PLANET_IMAGES; i++)
+    {
+      SDL_FreeSurface(planetImg[i]);
+    }
 
-  //Clean up TTF
+  //Clean up TTF, the digit atlases go first since they belong to the font
+  GlyphAtlas::clear();
   TTF_CloseFont(planetFont);
   TTF_Quit();
 
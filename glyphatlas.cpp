@@ -0,0 +1,139 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----GlyphAtlas Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the GlyphAtlas class.
+*/
+
+#ifndef _glyphatlas_cpp_
+#define _glyphatlas_cpp_
+
+#include "glyphatlas.h"
+#include <cstdio>
+
+std::map<std::pair<TTF_Font*, Uint32>, GlyphAtlas*> GlyphAtlas::atlases_;
+
+//Constructor, renders every character once and packs them side by side
+GlyphAtlas::GlyphAtlas(TTF_Font* font, SDL_Color color):
+  atlas_(NULL),
+  h_(0)
+{
+  //Render each glyph on its own
+  SDL_Surface* glyph[GLYPH_ATLAS_COUNT];
+  int total = 0;
+  for (int i = 0; i < GLYPH_ATLAS_COUNT; i++)
+    {
+      char text[2] = {GLYPH_ATLAS_CHARS[i], '\0'};
+      glyph[i] = TTF_RenderText_Solid(font, text, color);
+      x_[i] = total;
+      w_[i] = (glyph[i] != NULL) ? glyph[i]->w : 0;
+      if (glyph[i] != NULL && glyph[i]->h > h_) h_ = glyph[i]->h;
+      total += w_[i];
+    }
+
+  //Pack them onto a background that can't be the text color
+  //Solid text is color keyed, so blitting it leaves the background behind
+  atlas_ = SDL_CreateRGBSurface(SDL_SWSURFACE, (total > 0) ? total : 1, (h_ > 0) ? h_ : 1,
+				32, 0, 0, 0, 0);
+  Uint32 key = SDL_MapRGB(atlas_->format, 255 - color.r, 255 - color.g, 255 - color.b);
+  SDL_FillRect(atlas_, NULL, key);
+  for (int i = 0; i < GLYPH_ATLAS_COUNT; i++)
+    {
+      if (glyph[i] == NULL) continue;
+      SDL_Rect dest = {Sint16(x_[i]), 0, 0, 0};
+      SDL_BlitSurface(glyph[i], NULL, atlas_, &dest);
+      SDL_FreeSurface(glyph[i]);
+    }
+  SDL_SetColorKey(atlas_, SDL_SRCCOLORKEY | SDL_RLEACCEL, key);
+}
+
+//Destructor
+GlyphAtlas::~GlyphAtlas()
+{
+  SDL_FreeSurface(atlas_);
+}
+
+//Finds the index of a character in GLYPH_ATLAS_CHARS, or -1
+int GlyphAtlas::indexOf(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  for (int i = 10; i < GLYPH_ATLAS_COUNT; i++)
+    {
+      if (GLYPH_ATLAS_CHARS[i] == c) return i;
+    }
+  return -1;
+}
+
+//Writes value into buf as text, returning it
+//buf must hold at least 12 characters
+const char* GlyphAtlas::format(int value, char* buf)
+{
+  std::snprintf(buf, 12, "%d", value);
+  return buf;
+}
+
+//Width in pixels of text
+int GlyphAtlas::width(const char* text) const
+{
+  int total = 0;
+  for (; *text != '\0'; text++)
+    {
+      int i = indexOf(*text);
+      if (i >= 0) total += w_[i];
+    }
+  return total;
+}
+
+int GlyphAtlas::width(int value) const
+{
+  char buf[12];
+  return width(format(value, buf));
+}
+
+//Draws text with its top left corner at (x, y)
+void GlyphAtlas::draw(const char* text, SDL_Surface* screen, int x, int y) const
+{
+  for (; *text != '\0'; text++)
+    {
+      int i = indexOf(*text);
+      if (i < 0) continue;
+      SDL_Rect src = {Sint16(x_[i]), 0, Uint16(w_[i]), Uint16(h_)};
+      SDL_Rect dest = {Sint16(x), Sint16(y), 0, 0};
+      SDL_BlitSurface(atlas_, &src, screen, &dest);
+      x += w_[i];
+    }
+}
+
+void GlyphAtlas::draw(int value, SDL_Surface* screen, int x, int y) const
+{
+  char buf[12];
+  draw(format(value, buf), screen, x, y);
+}
+
+//Returns the shared atlas for a font and color, making it on first use
+GlyphAtlas& GlyphAtlas::get(TTF_Font* font, SDL_Color color)
+{
+  std::pair<TTF_Font*, Uint32> key(font, (Uint32(color.r) << 16) | (Uint32(color.g) << 8) | color.b);
+  std::map<std::pair<TTF_Font*, Uint32>, GlyphAtlas*>::iterator found = atlases_.find(key);
+  if (found != atlases_.end()) return *(found->second);
+
+  GlyphAtlas* atlas = new GlyphAtlas(font, color);
+  atlases_[key] = atlas;
+  return *atlas;
+}
+
+//Frees every shared atlas
+void GlyphAtlas::clear()
+{
+  for (std::map<std::pair<TTF_Font*, Uint32>, GlyphAtlas*>::iterator i = atlases_.begin(); i != atlases_.end(); i++)
+    {
+      delete i->second;
+    }
+  atlases_.clear();
+}
+
+#endif
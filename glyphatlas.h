@@ -0,0 +1,78 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----GlyphAtlas Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Draws numbers by blitting pre-rendered glyphs instead of rendering text.
+  The digits and a few separators are rendered once per font and color into
+  a single color keyed surface, and each character of a number is blitted out
+  of it. Nothing is rendered or allocated after the atlas is made.
+
+  Atlases are shared, one per font and color, through GlyphAtlas::get. They
+  must be freed with GlyphAtlas::clear before their fonts are closed.
+*/
+
+#ifndef _glyphatlas_h_
+#define _glyphatlas_h_
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#include <map>
+#include <utility>
+
+//The characters held by every atlas
+const char GLYPH_ATLAS_CHARS[] = "0123456789-,.";
+const int GLYPH_ATLAS_COUNT = sizeof(GLYPH_ATLAS_CHARS) - 1;
+
+class GlyphAtlas
+{
+ public:
+  //Accessors
+  //Width in pixels of text, which may only use GLYPH_ATLAS_CHARS
+  int width(const char* text) const;
+  int width(int value) const;
+  int height() const {return h_;}
+
+  //Draws text with its top left corner at (x, y)
+  //Characters not in the atlas are skipped
+  void draw(const char* text, SDL_Surface* screen, int x, int y) const;
+  void draw(int value, SDL_Surface* screen, int x, int y) const;
+
+  //The shared atlas for a font and color, made on first use
+  static GlyphAtlas& get(TTF_Font* font, SDL_Color color);
+
+  //Frees every shared atlas
+  static void clear();
+
+ private:
+  //Constructors/Destructor
+  //Copying is not allowed, atlases are only handed out by reference
+  GlyphAtlas(TTF_Font* font, SDL_Color color);
+  GlyphAtlas(const GlyphAtlas&);
+  GlyphAtlas& operator=(const GlyphAtlas&);
+  ~GlyphAtlas();
+
+  //Finds the index of a character in GLYPH_ATLAS_CHARS, or -1
+  static int indexOf(char c);
+
+  //Writes value into buf as text, returning it
+  static const char* format(int value, char* buf);
+
+  //Every glyph side by side
+  SDL_Surface* atlas_;
+
+  //Where each glyph starts in the atlas, and its width
+  int x_[GLYPH_ATLAS_COUNT];
+  int w_[GLYPH_ATLAS_COUNT];
+
+  //Height of every glyph
+  int h_;
+
+  //Every shared atlas, by font and packed color
+  static std::map<std::pair<TTF_Font*, Uint32>, GlyphAtlas*> atlases_;
+};
+
+#endif
@@ -6,8 +6,19 @@
   Auston Sterling
   austonst@gmail.com
 
-  Contains the implementation of the LineDrawer class, which draws (currently) Bresenham
-  lines on an assigned SDL_Surface*.
+  Contains the implementation of the LineDrawer class, which draws Bresenham lines, or
+  anti-aliased Xiaolin Wu lines, on an assigned SDL_Surface*.
+
+  Colors are kept in 16.16 fixed point and packed into pixels with the
+  surface's own shifts, so SDL_MapRGB is never called per pixel. Horizontal
+  lines are filled a run at a time, with an SSE2 version picked at runtime,
+  and vertical lines step straight down the surface.
+
+  Anti-aliased lines keep the position across the line in 16.16 fixed point
+  as well, and blend into the two pixels it falls between with 8 bit weights.
+  The SSE2 version blends both pixels of a pair at once, looking the weights
+  up by the fraction across, and costs no more than the Bresenham loop this
+  class started with (see linebench.cpp).
 */
 
 #ifndef _linedrawer_cpp_
@@ -15,165 +26,630 @@
 
 #include "lineDrawer.h"
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINE_X86 1
+#include <immintrin.h>
+#endif
+
+//Cohen-Sutherland outcodes, one bit for each side of the surface a point is past
+const int CLIP_LEFT = 1;
+const int CLIP_RIGHT = 2;
+const int CLIP_TOP = 4;
+const int CLIP_BOTTOM = 8;
+
+//Packs a color with 16 fractional bits per channel into a pixel of format f
+static inline Uint32 packPixel(const SDL_PixelFormat* f, int r, int g, int b)
+{
+  return (Uint32((r >> 16) >> f->Rloss) << f->Rshift) |
+    (Uint32((g >> 16) >> f->Gloss) << f->Gshift) |
+    (Uint32((b >> 16) >> f->Bloss) << f->Bshift) | f->Amask;
+}
+
+//Blends pixel s over pixel d, a out of 256 of the way
+//Each byte is blended separately, two at a time, which suits any layout of 8 bit channels
+static inline Uint32 blendBytes(Uint32 d, Uint32 s, int a)
+{
+  Uint32 lo = ((s & 0x00FF00FF) * a + (d & 0x00FF00FF) * (256 - a)) >> 8;
+  Uint32 hi = ((s >> 8 & 0x00FF00FF) * a + (d >> 8 & 0x00FF00FF) * (256 - a));
+  return (lo & 0x00FF00FF) | (hi & 0xFF00FF00);
+}
+
+//Blends pixel s over pixel d a channel at a time, for formats with channels of other sizes
+static inline Uint32 blendChannels(const SDL_PixelFormat* f, Uint32 d, Uint32 s, int a)
+{
+  Uint32 out = f->Amask;
+  Uint32 mask[3] = {f->Rmask, f->Gmask, f->Bmask};
+  Uint8 shift[3] = {f->Rshift, f->Gshift, f->Bshift};
+  for (int i = 0; i < 3; i++)
+    {
+      int sc = (s & mask[i]) >> shift[i], dc = (d & mask[i]) >> shift[i];
+      out |= (Uint32(dc + (sc - dc) * a / 256) << shift[i]) & mask[i];
+    }
+  return out;
+}
+
+//Fills n pixels with one color
+typedef void (*SolidRun)(Uint32* out, int n, Uint32 pixel);
+
+//Fills n pixels, starting from color r, g, b and stepping by dr, dg, db each pixel
+typedef void (*GradientRun)(Uint32* out, int n, int r, int g, int b, int dr, int dg, int db,
+			    const SDL_PixelFormat* f);
+
+static void solidRunScalar(Uint32* out, int n, Uint32 pixel)
+{
+  for (int i = 0; i < n; i++) out[i] = pixel;
+}
+
+static void gradientRunScalar(Uint32* out, int n, int r, int g, int b, int dr, int dg, int db,
+			      const SDL_PixelFormat* f)
+{
+  for (int i = 0; i < n; i++)
+    {
+      out[i] = packPixel(f, r, g, b);
+      r += dr;
+      g += dg;
+      b += db;
+    }
+}
+
+//An anti-aliased line on a surface with 8 bit channels, ready to step along
+struct SmoothSpan
+{
+  //The first pixel column or row, the pixels between steps along and across, and the last row across
+  Uint32* row;
+  int count;
+  int along, across, last;
+
+  //Position across the line and its change per step, in 16.16
+  int y, dy;
+
+  //Coverage of the end pixels, out of 256
+  int gap1, gap2;
+
+  //Color and its change per step, in 16.16
+  int r, g, b, dr, dg, db;
+
+  //Where the channels go in a pixel
+  int rshift, gshift, bshift;
+  Uint32 amask;
+};
+
+//Blends an anti-aliased line into its pixel pairs
+typedef void (*SmoothRun)(const SmoothSpan& span);
+
+//Blends one step of an anti-aliased line, weight out of 256 of it covered along the line
+static inline void smoothPixel(Uint32* row, int across, int y, int last, Uint32 pixel, int weight)
+{
+  //Rounding at the ends can stray a hair off the surface
+  int yc = std::min(std::max(y, 0), last);
+  int frac = (yc >> 8) & 255;
+
+  //Split the coverage between the two pixels the line passes between
+  int a1 = (256 - frac) * weight >> 8, a2 = frac * weight >> 8;
+
+  //A line right on a pixel leaves the next one alone, which is also how the
+  //clamp keeps the last row or column from blending past the edge
+  Uint32* out = row + (yc >> 16)*across;
+  *out = blendBytes(*out, pixel, a1);
+  if (a2 != 0) out[across] = blendBytes(out[across], pixel, a2);
+}
+
+//Everything is copied out of span first, as the pixel stores could otherwise alias it
+//Only the end pixels are partly covered along the line, so they are blended apart from the rest
+static void smoothRunScalar(const SmoothSpan& span)
+{
+  Uint32* row = span.row;
+  int count = span.count, along = span.along, across = span.across, last = span.last << 16;
+  int y = span.y, dy = span.dy;
+  int r = span.r, g = span.g, b = span.b, dr = span.dr, dg = span.dg, db = span.db;
+  int rshift = span.rshift, gshift = span.gshift, bshift = span.bshift;
+  Uint32 amask = span.amask;
+  for (int i = 0; i < count; i++, row += along)
+    {
+      Uint32 pixel = (Uint32(r >> 16) << rshift) | (Uint32(g >> 16) << gshift) |
+	(Uint32(b >> 16) << bshift) | amask;
+      if (i > 0 && i < count - 1) smoothPixel(row, across, y, last, pixel, 256);
+      else smoothPixel(row, across, y, last, pixel, (i == 0) ? span.gap1 : span.gap2);
+      y += dy;
+      r += dr;
+      g += dg;
+      b += db;
+    }
+}
+
+#ifdef LINE_X86
+__attribute__((target("sse2")))
+static void solidRunSSE2(Uint32* out, int n, Uint32 pixel)
+{
+  __m128i p = _mm_set1_epi32(pixel);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(out + i), p);
+  for (; i < n; i++) out[i] = pixel;
+}
+
+//Shifts one channel of four pixels from fixed point into place
+__attribute__((target("sse2")))
+static inline __m128i packChannelSSE2(__m128i c, __m128i down, __m128i up)
+{
+  return _mm_sll_epi32(_mm_srl_epi32(c, down), up);
+}
+
+//Works on four pixels at a time, one in each lane
+__attribute__((target("sse2")))
+static void gradientRunSSE2(Uint32* out, int n, int r, int g, int b, int dr, int dg, int db,
+			    const SDL_PixelFormat* f)
+{
+  int i = 0;
+  if (n >= 4)
+    {
+      __m128i vr = _mm_set_epi32(r + 3*dr, r + 2*dr, r + dr, r);
+      __m128i vg = _mm_set_epi32(g + 3*dg, g + 2*dg, g + dg, g);
+      __m128i vb = _mm_set_epi32(b + 3*db, b + 2*db, b + db, b);
+      __m128i sr = _mm_set1_epi32(4*dr), sg = _mm_set1_epi32(4*dg), sb = _mm_set1_epi32(4*db);
+      __m128i rdown = _mm_cvtsi32_si128(16 + f->Rloss), rup = _mm_cvtsi32_si128(f->Rshift);
+      __m128i gdown = _mm_cvtsi32_si128(16 + f->Gloss), gup = _mm_cvtsi32_si128(f->Gshift);
+      __m128i bdown = _mm_cvtsi32_si128(16 + f->Bloss), bup = _mm_cvtsi32_si128(f->Bshift);
+      __m128i alpha = _mm_set1_epi32(f->Amask);
+      for (; i + 4 <= n; i += 4)
+	{
+	  __m128i p = _mm_or_si128(alpha, packChannelSSE2(vr, rdown, rup));
+	  p = _mm_or_si128(p, packChannelSSE2(vg, gdown, gup));
+	  p = _mm_or_si128(p, packChannelSSE2(vb, bdown, bup));
+	  _mm_storeu_si128((__m128i*)(out + i), p);
+	  vr = _mm_add_epi32(vr, sr);
+	  vg = _mm_add_epi32(vg, sg);
+	  vb = _mm_add_epi32(vb, sb);
+	}
+      r += i*dr;
+      g += i*dg;
+      b += i*db;
+    }
+  gradientRunScalar(out + i, n - i, r, g, b, dr, dg, db, f);
+}
+
+//The weights of both pixels of a fully covered pair for each fraction across the line,
+//a channel to a 16 bit lane, and what is left of the old pixels
+static struct SmoothCoverage
+{
+  SmoothCoverage()
+  {
+    for (int frac = 0; frac < 256; frac++)
+      {
+	for (int k = 0; k < 8; k++)
+	  {
+	    weights[frac][k] = (k < 4) ? 256 - frac : frac;
+	    rest[frac][k] = 256 - weights[frac][k];
+	  }
+      }
+  }
+
+  Uint16 weights[256][8];
+  Uint16 rest[256][8];
+} smoothCoverage;
+
+//Blends one step of an anti-aliased line as smoothPixel does, color spread a byte to a 32 bit lane
+//Both pixels of the pair are blended at once, a pixel in each half and a channel in each 16 bit
+//lane, and each channel is blended as in blendBytes, so the pixels come out the same
+__attribute__((target("sse2")))
+static inline void smoothPixelSSE2(Uint32* row, int across, int y, int last, __m128i color, int weight)
+{
+  int yc = std::min(std::max(y, 0), last);
+  int frac = (yc >> 8) & 255;
+  int a1 = (256 - frac) * weight >> 8, a2 = frac * weight >> 8;
+
+  //With nothing to blend into the second pixel it stands in for the first, which
+  //keeps it on the surface, and is stored before the first so the first wins
+  Uint32* out = row + (yc >> 16)*across;
+  Uint32* next = (a2 != 0) ? out + across : out;
+
+  //Fully covered steps, the whole middle of a line, look their weights up
+  __m128i w, rest;
+  if (weight == 256)
+    {
+      w = _mm_loadu_si128((const __m128i*)smoothCoverage.weights[frac]);
+      rest = _mm_loadu_si128((const __m128i*)smoothCoverage.rest[frac]);
+    }
+  else
+    {
+      w = _mm_cvtsi32_si128(a1 | (a2 << 16));
+      w = _mm_unpacklo_epi16(w, w);
+      w = _mm_unpacklo_epi32(w, w);
+      rest = _mm_sub_epi16(_mm_set1_epi16(256), w);
+    }
+
+  __m128i zero = _mm_setzero_si128();
+  __m128i s = _mm_srli_epi32(color, 16);
+  s = _mm_packs_epi32(s, s);
+  __m128i d = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*out), _mm_cvtsi32_si128(*next));
+  d = _mm_unpacklo_epi8(d, zero);
+  __m128i blend = _mm_add_epi16(_mm_mullo_epi16(s, w), _mm_mullo_epi16(d, rest));
+  blend = _mm_packus_epi16(_mm_srli_epi16(blend, 8), zero);
+  *next = _mm_cvtsi128_si32(_mm_shuffle_epi32(blend, 1));
+  *out = _mm_cvtsi128_si32(blend);
+}
+
+//Keeps the color a byte of the pixel to a lane, so it steps and unpacks without being packed
+//Only the end pixels are partly covered along the line, so the middle looks its weights up
+__attribute__((target("sse2")))
+static void smoothRunSSE2(const SmoothSpan& span)
+{
+  //Bytes no channel covers hold whatever amask sets there
+  int lane[4], step[4] = {0, 0, 0, 0};
+  for (int k = 0; k < 4; k++) lane[k] = ((span.amask >> (8*k)) & 0xFF) << 16;
+  lane[span.rshift / 8] = span.r;
+  lane[span.gshift / 8] = span.g;
+  lane[span.bshift / 8] = span.b;
+  step[span.rshift / 8] = span.dr;
+  step[span.gshift / 8] = span.dg;
+  step[span.bshift / 8] = span.db;
+  __m128i color = _mm_setr_epi32(lane[0], lane[1], lane[2], lane[3]);
+  __m128i dcolor = _mm_setr_epi32(step[0], step[1], step[2], step[3]);
+
+  Uint32* row = span.row;
+  int count = span.count, along = span.along, across = span.across, last = span.last << 16;
+  int y = span.y, dy = span.dy;
+  smoothPixelSSE2(row, across, y, last, color, span.gap1);
+  for (int i = 1; i < count - 1; i++)
+    {
+      row += along;
+      y += dy;
+      color = _mm_add_epi32(color, dcolor);
+      smoothPixelSSE2(row, across, y, last, color, 256);
+    }
+  if (count > 1)
+    {
+      row += along;
+      y += dy;
+      color = _mm_add_epi32(color, dcolor);
+      smoothPixelSSE2(row, across, y, last, color, span.gap2);
+    }
+}
+#endif
+
+//Picks the fastest versions the CPU supports
+static SolidRun chooseSolid()
+{
+#ifdef LINE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) return solidRunSSE2;
+#endif
+  return solidRunScalar;
+}
+
+static GradientRun chooseGradient()
+{
+#ifdef LINE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) return gradientRunSSE2;
+#endif
+  return gradientRunScalar;
+}
+
+static SmoothRun chooseSmooth()
+{
+#ifdef LINE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) return smoothRunSSE2;
+#endif
+  return smoothRunScalar;
+}
+
+static const SolidRun solidRun = chooseSolid();
+static const GradientRun gradientRun = chooseGradient();
+static const SmoothRun smoothRun = chooseSmooth();
 
 //Default constructor
-LineDrawer::LineDrawer() : surf_(NULL)
+LineDrawer::LineDrawer() : surf_(NULL), mode_(LINE_ALIASED), batch_(0)
 {}
 
 //Better constructor
-LineDrawer::LineDrawer(SDL_Surface* insurf) : surf_(insurf)
+LineDrawer::LineDrawer(SDL_Surface* insurf) : surf_(insurf), mode_(LINE_ALIASED), batch_(0)
 {}
 
+//Locks the surface for every line until the matching end()
+void LineDrawer::begin()
+{
+  if (batch_++ == 0 && surf_ != NULL && SDL_MUSTLOCK(surf_)) SDL_LockSurface(surf_);
+}
+
+//Unlocks the surface once every begin() has been ended
+void LineDrawer::end()
+{
+  if (batch_ > 0 && --batch_ == 0 && surf_ != NULL && SDL_MUSTLOCK(surf_)) SDL_UnlockSurface(surf_);
+}
+
 //Draws a line on the SDL_Surface from p1 to p2 with color c
 void LineDrawer::line(Vec2f p1, Vec2f p2, SDL_Color c)
 {
-  //Find if the surface is longer in X or Y direction
-  bool steep = abs(p2.y() - p1.y()) > abs(p2.x() - p1.x());
-  if (steep)
-    {
-      float swapper = p2.y();
-      p2.sety(p2.x());
-      p2.setx(swapper);
-      swapper = p1.y();
-      p1.sety(p1.x());
-      p1.setx(swapper);
-    }
+  line(p1, p2, c, c);
+}
 
-  //Ensure the line increases from p1 to p2
-  if (p1.x() > p2.x())
+//Draws a line on the SDL_Surface from p1 (with color c1) to p2 (with color c2)
+void LineDrawer::line(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2)
+{
+  if (surf_ == NULL || surf_->format->BytesPerPixel != 4) return;
+
+  //Cut off anything past the edges, keeping the colors where they were
+  float t1, t2;
+  if (!clip(p1, p2, t1, t2)) return;
+  SDL_Color e1 = c1, e2 = c2;
+  if (t1 != 0 || t2 != 1)
     {
-      float swapper = p2.y();
-      p2.sety(p1.y());
-      p1.sety(swapper);
-      swapper = p2.x();
-      p2.setx(p1.x());
-      p1.setx(swapper);
+      e1.r = c1.r + (c2.r - c1.r) * t1 + .5;
+      e1.g = c1.g + (c2.g - c1.g) * t1 + .5;
+      e1.b = c1.b + (c2.b - c1.b) * t1 + .5;
+      e2.r = c1.r + (c2.r - c1.r) * t2 + .5;
+      e2.g = c1.g + (c2.g - c1.g) * t2 + .5;
+      e2.b = c1.b + (c2.b - c1.b) * t2 + .5;
     }
 
-  //Find the change in x and y and initialize variables
-  int dx = p2.x() - p1.x();
-  int dy = abs(p2.y() - p1.y());
-  int error = dx/2;
-  int ystep = (p1.y() < p2.y())?1:-1;
-  int y = p1.y();
+  begin();
+  if (mode_ == LINE_ANTIALIASED) drawSmooth(p1, p2, e1, e2);
+  else draw(p1, p2, e1, e2);
+  end();
+}
 
-  //Set up the SDL_Surface
-  if (SDL_MUSTLOCK(surf_)) SDL_LockSurface(surf_);
-  Uint32* pixels = (Uint32*)surf_->pixels;
+//Finds which sides of the surface a point is past
+int LineDrawer::outcode(float x, float y) const
+{
+  int code = 0;
+  if (x < 0) code |= CLIP_LEFT;
+  else if (x > surf_->w - 1) code |= CLIP_RIGHT;
+  if (y < 0) code |= CLIP_TOP;
+  else if (y > surf_->h - 1) code |= CLIP_BOTTOM;
+  return code;
+}
 
-  //Loop over line
-  for (int x = p1.x(); x < p2.x(); x++)
+//Cuts the line down to the part on the surface with Cohen-Sutherland
+bool LineDrawer::clip(Vec2f& p1, Vec2f& p2, float& t1, float& t2) const
+{
+  Vec2f start = p1, delta = p2 - p1;
+  float right = surf_->w - 1, bottom = surf_->h - 1;
+  int code1 = outcode(p1.x(), p1.y());
+  int code2 = outcode(p2.x(), p2.y());
+
+  //Each end is moved onto at most two edges
+  for (int pass = 0; pass < 4 && (code1 | code2); pass++)
     {
-      //Plot the point
-      if (!steep)
+      //Both ends past the same edge, so nothing is on the surface
+      if (code1 & code2) return false;
+
+      //Move an end that's off the surface onto the edge it's past
+      int code = code1 ? code1 : code2;
+      float x, y;
+      if (code & CLIP_TOP)
+	{
+	  x = p1.x() + (p2.x() - p1.x()) * (0 - p1.y()) / (p2.y() - p1.y());
+	  y = 0;
+	}
+      else if (code & CLIP_BOTTOM)
 	{
-	  pixels[x + y*surf_->w] = SDL_MapRGB(surf_->format, c.r, c.g, c.b);
+	  x = p1.x() + (p2.x() - p1.x()) * (bottom - p1.y()) / (p2.y() - p1.y());
+	  y = bottom;
+	}
+      else if (code & CLIP_LEFT)
+	{
+	  y = p1.y() + (p2.y() - p1.y()) * (0 - p1.x()) / (p2.x() - p1.x());
+	  x = 0;
 	}
       else
 	{
-	  pixels[y + x*surf_->w] = SDL_MapRGB(surf_->format, c.r, c.g, c.b);
+	  y = p1.y() + (p2.y() - p1.y()) * (right - p1.x()) / (p2.x() - p1.x());
+	  x = right;
 	}
 
-      //Modify the error
-      error -= dy;
-      if (error < 0)
+      if (code == code1)
 	{
-	  y += ystep;
-	  error += dx;
+	  p1.set(x, y);
+	  code1 = outcode(x, y);
+	}
+      else
+	{
+	  p2.set(x, y);
+	  code2 = outcode(x, y);
 	}
     }
+  if (code1 & code2) return false;
+
+  //Rounding can leave an end a hair outside, so pull it back in
+  p1.set(std::min(std::max(p1.x(), 0.0f), right), std::min(std::max(p1.y(), 0.0f), bottom));
+  p2.set(std::min(std::max(p2.x(), 0.0f), right), std::min(std::max(p2.y(), 0.0f), bottom));
 
-  //Unlock the surface if needed
-  if (SDL_MUSTLOCK(surf_)) SDL_UnlockSurface(surf_);
+  //Find how far along the original line the ends are, along its longer direction
+  t1 = 0;
+  t2 = 1;
+  if (std::abs(delta.x()) >= std::abs(delta.y()) && delta.x() != 0)
+    {
+      t1 = (p1.x() - start.x()) / delta.x();
+      t2 = (p2.x() - start.x()) / delta.x();
+    }
+  else if (delta.y() != 0)
+    {
+      t1 = (p1.y() - start.y()) / delta.y();
+      t2 = (p2.y() - start.y()) / delta.y();
+    }
+  return true;
 }
 
-//Draws a line on the SDL_Surface from p1 (with color c1) to p2 (with color c2)
-void LineDrawer::line(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2)
+//Packs a color with 16 fractional bits per channel into a pixel of the surface
+Uint32 LineDrawer::pack(int r, int g, int b) const
 {
-  //Find if the surface is longer in X or Y direction
-  bool steep = abs(p2.y() - p1.y()) > abs(p2.x() - p1.x());
+  return packPixel(surf_->format, r, g, b);
+}
+
+//Draws a line that is entirely on the surface, which must be locked
+void LineDrawer::draw(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2)
+{
+  int x1 = p1.x(), y1 = p1.y(), x2 = p2.x(), y2 = p2.y();
+
+  //Find if the line is longer in X or Y direction, and walk along that one
+  bool steep = abs(y2 - y1) > abs(x2 - x1);
   if (steep)
     {
-      float swapper = p2.y();
-      p2.sety(p2.x());
-      p2.setx(swapper);
-      swapper = p1.y();
-      p1.sety(p1.x());
-      p1.setx(swapper);
+      std::swap(x1, y1);
+      std::swap(x2, y2);
     }
 
   //Ensure the line increases from p1 to p2
-  if (p1.x() > p2.x())
+  if (x1 > x2)
     {
-      float swapper = p2.y();
-      p2.sety(p1.y());
-      p1.sety(swapper);
-      swapper = p2.x();
-      p2.setx(p1.x());
-      p1.setx(swapper);
-      SDL_Color colorswap = c1;
-      c1 = c2;
-      c2 = colorswap;
+      std::swap(x1, x2);
+      std::swap(y1, y2);
+      std::swap(c1, c2);
     }
 
   //Find the change in x and y and initialize variables
-  int dx = p2.x() - p1.x();
-  int dy = abs(p2.y() - p1.y());
-  int error = dx/2;
-  int ystep = (p1.y() < p2.y())?1:-1;
-  int y = p1.y();
-
-  //Find the change in color per x step
-  float cr, cg, cb;
-  cr = c1.r;
-  cg = c1.g;
-  cb = c1.b;
-  
-  float dcr, dcg, dcb;
+  int dx = x2 - x1;
+  int dy = abs(y2 - y1);
+  int count = dx + 1;
+
+  //Find the color and its change per x step, in 16.16 fixed point
+  int r = c1.r * 65536 + 32768, g = c1.g * 65536 + 32768, b = c1.b * 65536 + 32768;
+  int dr = 0, dg = 0, db = 0;
   if (dx != 0)
     {
-      dcr = float(c2.r - c1.r) / float(dx);
-      dcg = float(c2.g - c1.g) / float(dx);
-      dcb = float(c2.b - c1.b) / float(dx);
+      dr = (c2.r - c1.r) * 65536 / dx;
+      dg = (c2.g - c1.g) * 65536 / dx;
+      db = (c2.b - c1.b) * 65536 / dx;
     }
-  else
+  bool solid = dr == 0 && dg == 0 && db == 0;
+  Uint32 pixel = pack(r, g, b);
+
+  //Find the first pixel, and how far apart pixels are along and across the line
+  int pitch = surf_->pitch / 4;
+  Uint32* out = (Uint32*)surf_->pixels + (steep ? x1*pitch + y1 : y1*pitch + x1);
+  int along = steep ? pitch : 1;
+  int across = (y1 < y2 ? 1 : -1) * (steep ? 1 : pitch);
+
+  //Horizontal lines are one run of pixels
+  if (dy == 0 && !steep)
     {
-      dcr = dcg = dcb = 0;
+      if (solid) solidRun(out, count, pixel);
+      else gradientRun(out, count, r, g, b, dr, dg, db, surf_->format);
+      return;
     }
 
-  //Set up the SDL_Surface
-  if (SDL_MUSTLOCK(surf_)) SDL_LockSurface(surf_);
-  Uint32* pixels = (Uint32*)surf_->pixels;
+  //Vertical lines step straight down
+  if (dy == 0)
+    {
+      for (int i = 0; i < count; i++, out += along)
+	{
+	  *out = solid ? pixel : pack(r, g, b);
+	  r += dr;
+	  g += dg;
+	  b += db;
+	}
+      return;
+    }
 
   //Loop over line
-  for (int x = p1.x(); x < p2.x(); x++)
+  int error = dx/2;
+  for (int i = 0; i < count; i++, out += along)
     {
       //Plot the point
-      if (!steep)
-	{
-	  pixels[x + y*surf_->w] = SDL_MapRGB(surf_->format, cr, cg, cb);
-	}
-      else
-	{
-	  pixels[y + x*surf_->w] = SDL_MapRGB(surf_->format, cr, cg, cb);
-	}
+      *out = solid ? pixel : pack(r, g, b);
 
       //Modify the error
       error -= dy;
       if (error < 0)
 	{
-	  y += ystep;
+	  out += across;
 	  error += dx;
 	}
 
       //Modify color
-      cr += dcr;
-      cg += dcg;
-      cb += dcb;
+      r += dr;
+      g += dg;
+      b += db;
+    }
+}
+
+//Draws an anti-aliased line that is entirely on the surface, which must be locked
+void LineDrawer::drawSmooth(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2)
+{
+  float x1 = p1.x(), y1 = p1.y(), x2 = p2.x(), y2 = p2.y();
+
+  //Walk along the longer direction, increasing
+  bool steep = std::abs(y2 - y1) > std::abs(x2 - x1);
+  if (steep)
+    {
+      std::swap(x1, y1);
+      std::swap(x2, y2);
+    }
+  if (x1 > x2)
+    {
+      std::swap(x1, x2);
+      std::swap(y1, y2);
+      std::swap(c1, c2);
+    }
+
+  //The ends are ahead of the origin, so adding a half and truncating rounds them
+  int xs = x1 + .5, xe = x2 + .5;
+  int count = xe - xs + 1;
+
+  //Find the position across the line at the first pixel and its change per step, in 16.16
+  float slope = (x2 > x1) ? (y2 - y1) / (x2 - x1) : 0;
+  int y = (y1 + slope * (xs - x1)) * 65536;
+  int dy = slope * 65536;
+
+  //The end pixels are only partly covered along the line
+  int gap1 = (1 - (x1 + .5 - xs)) * 256;
+  int gap2 = (x2 + .5 - xe) * 256;
+  if (count == 1) gap1 = gap2 = 256;
+
+  //Find the color and its change per step, in 16.16 fixed point
+  int r = c1.r * 65536 + 32768, g = c1.g * 65536 + 32768, b = c1.b * 65536 + 32768;
+  int dr = 0, dg = 0, db = 0;
+  if (count > 1)
+    {
+      dr = (c2.r - c1.r) * 65536 / (count - 1);
+      dg = (c2.g - c1.g) * 65536 / (count - 1);
+      db = (c2.b - c1.b) * 65536 / (count - 1);
+    }
+
+  //Pixels are found as in draw(), with the second of each pair one further across
+  const SDL_PixelFormat* f = surf_->format;
+  int pitch = surf_->pitch / 4;
+  int along = steep ? pitch : 1;
+  int across = steep ? 1 : pitch;
+  int last = (steep ? surf_->w : surf_->h) - 1;
+  Uint32* row = (Uint32*)surf_->pixels + xs*along;
+
+  //Surfaces with whole bytes for channels, as nearly all are, take the fast path
+  if (!(f->Rloss | f->Gloss | f->Bloss) && !((f->Rshift | f->Gshift | f->Bshift) & 7))
+    {
+      SmoothSpan span = {row, count, along, across, last, y, dy, gap1, gap2,
+			 r, g, b, dr, dg, db, f->Rshift, f->Gshift, f->Bshift, f->Amask};
+      smoothRun(span);
+      return;
     }
 
-  //Unlock the surface if needed
-  if (SDL_MUSTLOCK(surf_)) SDL_UnlockSurface(surf_);
+  for (int i = 0; i < count; i++, row += along)
+    {
+      //Rounding at the ends can stray a hair off the surface
+      int yc = std::min(std::max(y, 0), last << 16);
+      int yi = yc >> 16;
+      int frac = (yc >> 8) & 255;
+
+      //Split the coverage between the two pixels the line passes between
+      int weight = (i == 0) ? gap1 : (i == count - 1) ? gap2 : 256;
+      int a1 = (256 - frac) * weight >> 8, a2 = frac * weight >> 8;
+      Uint32 pixel = pack(r, g, b);
+
+      //A line right on a pixel leaves the next one alone, which is also how the
+      //clamp keeps the last row or column from blending past the edge
+      Uint32* out = row + yi*across;
+      *out = blendChannels(f, *out, pixel, a1);
+      if (a2 != 0) out[across] = blendChannels(f, out[across], pixel, a2);
+
+      y += dy;
+      r += dr;
+      g += dg;
+      b += db;
+    }
 }
 
 #endif
@@ -6,8 +6,12 @@
   Auston Sterling
   austonst@gmail.com
 
-  Contains the declaration of the LineDrawer class, which draws (currently) Bresenham
-  lines on an assigned SDL_Surface*.
+  Contains the declaration of the LineDrawer class, which draws Bresenham lines, or
+  anti-aliased Xiaolin Wu lines, on an assigned SDL_Surface*.
+
+  Lines are clipped to the surface first, so either end may be off of it.
+  Lines drawn between begin() and end() share a single lock of the surface,
+  which is how a whole frame of beams should be drawn.
 */
 
 #ifndef _linedrawer_h_
@@ -16,6 +20,13 @@
 #include "vec2f.h"
 #include <SDL/SDL.h>
 
+//How lines are drawn
+enum LineMode
+{
+  LINE_ALIASED,     //Bresenham, one solid pixel per step
+  LINE_ANTIALIASED  //Xiaolin Wu, two pixels per step blended by how much the line covers them
+};
+
 class LineDrawer
 {
  public:
@@ -24,18 +35,46 @@ class LineDrawer
   LineDrawer(SDL_Surface* insurf);
 
   //Mutators
+  //Don't change the surface between begin() and end()
   void setSurface(SDL_Surface* insurf) {surf_ = insurf;}
+  void setMode(LineMode inmode) {mode_ = inmode;}
+
+  //Accessors
+  LineMode mode() const {return mode_;}
+
+  //Batching
+  //Locks the surface until the matching end(), may be nested
+  void begin();
+  void end();
 
   //General use functions
+  //Only 32 bit surfaces are drawn on
   void line(Vec2f p1, Vec2f p2, SDL_Color c);
   void line(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2);
   
  private:
+  //Finds which sides of the surface a point is past, as Cohen-Sutherland outcodes
+  int outcode(float x, float y) const;
+
+  //Cuts the line down to the part on the surface, returning false if none is
+  //Also finds how far along the original line the new ends are, from 0 to 1
+  bool clip(Vec2f& p1, Vec2f& p2, float& t1, float& t2) const;
+
+  //Packs a color with 16 fractional bits per channel into a pixel of the surface
+  Uint32 pack(int r, int g, int b) const;
+
+  //Draws an already clipped line, blending from c1 to c2
+  void draw(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2);
+  void drawSmooth(Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2);
+
   //The SDL_Surface to draw to
   SDL_Surface* surf_;
 
-  //Any other settings?
-  //...
+  //How lines are drawn
+  LineMode mode_;
+
+  //How many begin() calls have not yet been ended
+  int batch_;
 };
 
 #endif
@@ -0,0 +1,208 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Line Benchmark-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Times 10000 random lines, in one color and fading between two, drawn by the
+  original Bresenham loop and by LineDrawer aliased and anti-aliased. Beams
+  have to cost no more anti-aliased than the original loop did, which locked
+  the surface for each line and called SDL_MapRGB for each pixel.
+
+  Each version keeps the fastest of a few passes and prints a checksum of the
+  surface, so changes to the drawing can be checked to leave the pixels alone.
+  Build with "make bench".
+*/
+
+//Compiled in here so the drawing is optimized like the rest of the bench
+#include "lineDrawer.cpp"
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+const int BENCH_W = 800;
+const int BENCH_H = 600;
+const int BENCH_LINES = 10000;
+const int BENCH_PASSES = 10;
+
+//Draws every line, each pair of ends and colors in turn
+typedef void (*DrawLines)(SDL_Surface* surf, const std::vector<Vec2f>& ends,
+			  const std::vector<SDL_Color>& colors);
+
+//A random pixel coordinate on the surface
+//The original loop didn't clip, and could step past the end of lines with fractional ends
+static float coord(int size)
+{
+  return std::rand() % size;
+}
+
+static SDL_Color randomColor()
+{
+  SDL_Color c = {Uint8(std::rand()), Uint8(std::rand()), Uint8(std::rand())};
+  return c;
+}
+
+//The Bresenham loop LineDrawer started with, for reference
+static void referenceLine(SDL_Surface* surf, Vec2f p1, Vec2f p2, SDL_Color c1, SDL_Color c2)
+{
+  //Find if the surface is longer in X or Y direction
+  bool steep = std::abs(p2.y() - p1.y()) > std::abs(p2.x() - p1.x());
+  if (steep)
+    {
+      p1.set(p1.y(), p1.x());
+      p2.set(p2.y(), p2.x());
+    }
+
+  //Ensure the line increases from p1 to p2
+  if (p1.x() > p2.x())
+    {
+      std::swap(p1, p2);
+      std::swap(c1, c2);
+    }
+
+  //Find the change in x and y and initialize variables
+  int dx = p2.x() - p1.x();
+  int dy = std::abs(p2.y() - p1.y());
+  int error = dx/2;
+  int ystep = (p1.y() < p2.y())?1:-1;
+  int y = p1.y();
+
+  //Find the change in color per x step
+  float cr = c1.r, cg = c1.g, cb = c1.b;
+  float dcr = 0, dcg = 0, dcb = 0;
+  if (dx != 0)
+    {
+      dcr = float(c2.r - c1.r) / float(dx);
+      dcg = float(c2.g - c1.g) / float(dx);
+      dcb = float(c2.b - c1.b) / float(dx);
+    }
+
+  //Set up the SDL_Surface
+  if (SDL_MUSTLOCK(surf)) SDL_LockSurface(surf);
+  Uint32* pixels = (Uint32*)surf->pixels;
+
+  //Loop over line
+  for (int x = p1.x(); x < p2.x(); x++)
+    {
+      //Plot the point
+      if (!steep) pixels[x + y*surf->w] = SDL_MapRGB(surf->format, cr, cg, cb);
+      else pixels[y + x*surf->w] = SDL_MapRGB(surf->format, cr, cg, cb);
+
+      //Modify the error
+      error -= dy;
+      if (error < 0)
+	{
+	  y += ystep;
+	  error += dx;
+	}
+
+      //Modify color
+      cr += dcr;
+      cg += dcg;
+      cb += dcb;
+    }
+
+  //Unlock the surface if needed
+  if (SDL_MUSTLOCK(surf)) SDL_UnlockSurface(surf);
+}
+
+static void drawReference(SDL_Surface* surf, const std::vector<Vec2f>& ends,
+			  const std::vector<SDL_Color>& colors)
+{
+  for (unsigned int i = 0; i < ends.size(); i += 2)
+    {
+      referenceLine(surf, ends[i], ends[i+1], colors[i], colors[i+1]);
+    }
+}
+
+//Draws a frame of lines with LineDrawer, as the renderer draws beams
+static void drawBatch(SDL_Surface* surf, LineMode mode, const std::vector<Vec2f>& ends,
+		      const std::vector<SDL_Color>& colors)
+{
+  LineDrawer draw(surf);
+  draw.setMode(mode);
+  draw.begin();
+  for (unsigned int i = 0; i < ends.size(); i += 2)
+    {
+      draw.line(ends[i], ends[i+1], colors[i], colors[i+1]);
+    }
+  draw.end();
+}
+
+static void drawAliased(SDL_Surface* surf, const std::vector<Vec2f>& ends,
+			const std::vector<SDL_Color>& colors)
+{
+  drawBatch(surf, LINE_ALIASED, ends, colors);
+}
+
+static void drawSmooth(SDL_Surface* surf, const std::vector<Vec2f>& ends,
+		       const std::vector<SDL_Color>& colors)
+{
+  drawBatch(surf, LINE_ANTIALIASED, ends, colors);
+}
+
+//The ways of drawing lines that are timed against each other
+const int BENCH_WAYS = 3;
+const char* const wayNames[BENCH_WAYS] = {"original loop", "aliased", "anti-aliased"};
+const DrawLines ways[BENCH_WAYS] = {drawReference, drawAliased, drawSmooth};
+
+//Draws the lines every way, faded or not, and prints the times and checksums
+//Passes take turns between the ways, so a busy machine slows them all alike
+static void run(bool fade)
+{
+  //The same lines every run
+  std::srand(1);
+  std::vector<Vec2f> ends;
+  std::vector<SDL_Color> colors;
+  for (int i = 0; i < BENCH_LINES; i++)
+    {
+      ends.push_back(Vec2f(coord(BENCH_W), coord(BENCH_H)));
+      ends.push_back(Vec2f(coord(BENCH_W), coord(BENCH_H)));
+      colors.push_back(randomColor());
+      colors.push_back(fade ? randomColor() : colors.back());
+    }
+
+  //Keep the fastest pass of each, each on a cleared surface
+  SDL_Surface* surf = SDL_CreateRGBSurface(SDL_SWSURFACE, BENCH_W, BENCH_H, 32,
+					   0xFF0000, 0x00FF00, 0x0000FF, 0);
+  double best[BENCH_WAYS];
+  Uint32 sum[BENCH_WAYS];
+  for (int pass = 0; pass < BENCH_PASSES; pass++)
+    {
+      for (int w = 0; w < BENCH_WAYS; w++)
+	{
+	  SDL_FillRect(surf, NULL, 0);
+	  std::clock_t start = std::clock();
+	  ways[w](surf, ends, colors);
+	  double taken = double(std::clock() - start) / CLOCKS_PER_SEC;
+	  if (pass == 0 || taken < best[w]) best[w] = taken;
+
+	  sum[w] = 0;
+	  for (int j = 0; j < BENCH_H; j++)
+	    {
+	      const Uint32* row = (const Uint32*)((const Uint8*)surf->pixels + j * surf->pitch);
+	      for (int i = 0; i < BENCH_W; i++) sum[w] = sum[w] * 31 + row[i];
+	    }
+	}
+    }
+  SDL_FreeSurface(surf);
+
+  std::cout << (fade ? "faded" : "solid") << std::endl;
+  for (int w = 0; w < BENCH_WAYS; w++)
+    {
+      std::cout << "  " << wayNames[w] << ": " << best[w] * 1000 << "ms, checksum "
+		<< std::hex << sum[w] << std::dec << std::endl;
+    }
+  std::cout << "  anti-aliased takes " << best[2] / best[0] << " of the original" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << BENCH_LINES << " lines on " << BENCH_W << "x" << BENCH_H << std::endl;
+  run(false);
+  run(true);
+  return 0;
+}
@@ -0,0 +1,29 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Payload Struct-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Contains the Payload struct for "Galcon", which describes what is delivered
+  to a fleet when a projectile or aura hits it.
+*/
+
+#ifndef _payload_h_
+#define _payload_h_
+
+//The kinds of payloads
+const char PAYLOAD_NONE = 0;
+const char PAYLOAD_DAMAGE = 1;
+
+struct Payload
+{
+  //One of the PAYLOAD_ constants
+  char kind;
+
+  //The strength of the payload, such as the amount of damage
+  float amount;
+};
+
+#endif
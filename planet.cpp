@@ -12,18 +12,25 @@
 #include "scale.h"
 #include "planet.h"
 #include "SDL/SDL.h"
-#include "SDL/SDL_ttf.h"
-#include "rotationcache.h"
+#include "rotationregistry.h"
 #include "vec2f.h"
 #include <cmath>
 #include <string>
-#include <sstream>
 #include <cstdlib>
 #include <algorithm>
 
 #ifndef _planet_cpp_
 #define _planet_cpp_
 
+//Rounds a planet size to the nearest PLANET_IMAGE_SCALE_STEP for its image
+//Planets within a step share the same rotations, and differ by a pixel or two
+static float imageScale(float size)
+{
+  float steps = std::floor(size / PLANET_IMAGE_SCALE_STEP + 0.5f);
+  if (steps < 1) steps = 1;
+  return steps * PLANET_IMAGE_SCALE_STEP;
+}
+
 //Default constructor
 Planet::Planet()
 {
@@ -31,15 +38,12 @@ Planet::Planet()
   rotspeed_ = 0;
   pos_ = Vec2f(0,0);
   size_ = 1.0;
-  time_ = 0;
   type_ = 0;
   building_.resize(1);
   ship_.resize(10);
-  countImg_ = NULL;
-  count_ = 0;
   owner_ = 0;
-  indicator_ = NULL;
   typeInfo_ = 0;
+  index_ = -1;
 }
 
 //Regular constructor
@@ -48,19 +52,14 @@ Planet::Planet(SDL_Surface* surf, float size, Vec2f loc, int type):
   rotspeed_(0),
   pos_(loc),
   size_(size),
-  time_(0),
   type_(type),
   buildIndex_(-1),
   buildTime_(0),
-  countImg_(NULL),
-  count_(0),
   owner_(0),
-  indicator_(NULL)
+  index_(-1)
 {
-  //Set rotation
-  SDL_Surface* scaled = scaleNN(surf, size);
-  rotation_ = RotationCache(scaled, NUM_PLANET_ROTATIONS);
-  SDL_FreeSurface(scaled);
+  //Set rotation, shared with every other planet of this image and size
+  rotation_ = SharedRotation(surf, imageScale(size), NUM_PLANET_ROTATIONS, PLANET_ROTATION_FILTER);
   //Figure out how many buildings this planet can hold
   float buildcount = (2 * 3.14159265358979323) / (std::asin((BUILDING_WIDTH >> 1) / (UNSCALED_PLANET_RADIUS * size_)) * 2);
   building_.resize((int)buildcount, NULL);
@@ -73,12 +72,6 @@ Planet::Planet(SDL_Surface* surf, float size, Vec2f loc, int type):
     }
 }
 
-//Destructor
-Planet::~Planet()
-{
-  if (indicator_ != NULL) SDL_FreeSurface(indicator_);
-}
-
 //Returns the total attack power of the planet
 float Planet::totalAttack(const std::vector<ShipStats> & shipstats) const
 {
@@ -101,11 +94,51 @@ float Planet::totalDefense(const std::vector<ShipStats> & shipstats) const
   return def * PLANET_DAMAGE_MULT[type_];
 }
 
-//Displays the current rotation of the planet to the screen along with each building
-void Planet::display(SDL_Surface* screen, TTF_Font* font, const SDL_Rect& camera)
+//Returns the number of ships of a type owned by player in fleets headed here
+int Planet::incomingShips(int player, int type) const
 {
-  //Create rectangle
-  SDL_Rect outrect;
+  if (player < 0 || player >= int(incoming_.size()) || type >= int(incoming_[player].size())) return 0;
+  return incoming_[player][type];
+}
+
+//Returns the total attack power of player's fleets headed here
+float Planet::incomingAttack(int player, const std::vector<ShipStats>& shipstats) const
+{
+  if (player < 0 || player >= int(incoming_.size())) return 0;
+  float att = 0;
+  for (unsigned int i = 0; i < incoming_[player].size(); i++)
+    {
+      att += float(incoming_[player][i]) * shipstats[i].attack;
+    }
+  return att;
+}
+
+//Returns the total defense of player's fleets headed here
+float Planet::incomingDefense(int player, const std::vector<ShipStats>& shipstats) const
+{
+  if (player < 0 || player >= int(incoming_.size())) return 0;
+  float def = 0;
+  for (unsigned int i = 0; i < incoming_[player].size(); i++)
+    {
+      def += float(incoming_[player][i]) * shipstats[i].defense;
+    }
+  return def;
+}
+
+//Adds ships to the count headed here, or removes them if ships is negative
+void Planet::addIncoming(int player, int type, int ships)
+{
+  if (player >= int(incoming_.size())) incoming_.resize(player+1);
+  if (type >= int(incoming_[player].size())) incoming_[player].resize(type+1, 0);
+  incoming_[player][type] += ships;
+}
+
+//Records the planet, its buildings, indicator and ship count for the renderer
+//dt is the length of the last step, to find how far the planet turned during it
+void Planet::record(RenderList& list, int dt) const
+{
+  float spin = rotspeed_ * ((float)dt / 1000);
+  Vec2f middle = pos_ + Vec2f(rotation_->width()/2, rotation_->height()/2);
 
   //For each building
   float attachAngle = 0;
@@ -117,110 +150,48 @@ void Planet::display(SDL_Surface* screen, TTF_Font* font, const SDL_Rect& camera
 	  float angle = attachAngle + rot_;
 
 	  //Find radius for building
-	  float rad = (UNSCALED_PLANET_RADIUS * size_) + building_[i].rotation(0)->h/5;
-
-	  //Calculate coordinates
-	  outrect.x = (std::cos(angle) * rad) + pos_.x() + (rotation_.rotation(0)->w/2) - building_[i].rotation(0)->w/2;
-	  outrect.y = (std::sin(angle) * rad) + pos_.y() + (rotation_.rotation(0)->h/2) - building_[i].rotation(0)->h/2;
-
-	  //Change by camera
-	  outrect.x -= camera.x;
-	  outrect.y -= camera.y;
-	  
-	  //Display
-	  building_[i].display(Vec2f(outrect.x, outrect.y), angle + 3.14159265358979323/2, screen, (buildIndex_==Sint32(i))?false:true);
+	  int bw = building_[i].width(), bh = building_[i].height();
+	  float rad = (UNSCALED_PLANET_RADIUS * size_) + bh/5;
+
+	  //Calculate coordinates now and as of the last step
+	  Vec2f corner = middle + Vec2f(std::cos(angle) * rad - bw/2, std::sin(angle) * rad - bh/2);
+	  Vec2f last = middle + Vec2f(std::cos(angle - spin) * rad - bw/2, std::sin(angle - spin) * rad - bh/2);
+	  list.sprite(building_[i].sprite(buildIndex_ != Sint32(i)), angle + 3.14159265358979323/2, spin,
+		      corner, corner - last);
 	}
 
       //Add to attachAngle
       attachAngle += 2 * 3.14159265358979323 / building_.size();
     }
 
-  //Draw planet
-  outrect.x = pos_.x() - camera.x;
-  outrect.y = pos_.y() - camera.y;
-  SDL_BlitSurface(rotation_.rotation(rot_), NULL, screen, &outrect);
+  //Record planet
+  list.sprite(rotation_, rot_, spin, pos_, Vec2f(0, 0));
 
-  //Draw indicator
+  //Record indicator
   if (owner_ != 0)
     {
       //Magic numbers here! Change?
-      outrect.x = pos_.x() - (6 * size_) - camera.x;
-      outrect.y = pos_.y() - (6 * size_) - camera.y;
-      SDL_BlitSurface(indicator_, NULL, screen, &outrect);
+      list.image(indicator_, pos_ - Vec2f(6 * size_, 6 * size_));
     }
 
-  //Draw total ship count
-
-  //Update count image here as opposed to update() since it only needs to be done once
-  //per draw, at most
-  //First time through
-  if (countImg_ == NULL)
-    {
-      //Find count
-      count_ = 0;
-      for (unsigned int i = 0; i < ship_.size(); i++)
-	{
-	  if (ship_[i].first > 0.99)
-	    {
-	      count_ += ship_[i].first;
-	    }
-	}
-      
-      //Create image
-      std::stringstream ss;
-      ss << count_;
-      countImg_ = TTF_RenderText_Solid(font, ss.str().c_str(), {0,255,255});
-    }
-  else
+  //Record total ship count
+  //Find sum of ships
+  float total = 0;
+  for (unsigned int i = 0; i < ship_.size(); i++)
     {
-      //Find sum of ships
-      float newCount = 0;
-      for (unsigned int i = 0; i < ship_.size(); i++)
+      if (ship_[i].first > 0.99)
 	{
-	  if (ship_[i].first > 0.99)
-	    {
-	      newCount += ship_[i].first;
-	    }
+	  total += ship_[i].first;
 	}
-
-      //Compare to last frame's count
-      if (newCount != count_)
-	{
-	  //Delete old image
-	  SDL_FreeSurface(countImg_);
-	  std::stringstream ss;
-	  ss << int(newCount);
-	  countImg_ = TTF_RenderText_Solid(font, ss.str().c_str(), {0,255,255});
-	}
-
-      //Update ship count
-      count_ = newCount;
     }
-
-  //Draw ship count
-  outrect.x = pos_.x() + (UNSCALED_PLANET_RADIUS * size_) - (countImg_->w/2) - camera.x;
-  outrect.y = pos_.y() + (UNSCALED_PLANET_RADIUS * size_) - (countImg_->h/2) - camera.y;
-  SDL_BlitSurface(countImg_, NULL, screen, &outrect);
+  int count = total;
+  list.count(count, pos_ + Vec2f(UNSCALED_PLANET_RADIUS * size_, UNSCALED_PLANET_RADIUS * size_), PLANET_COUNT_COLOR);
 }
 
 //Progresses anything that needs to be progressed
-void Planet::update()
+void Planet::update(const SimClock& clock)
 {
-  int dt;
-  
-  //See if this is the first run
-  if (time_ == 0)
-    {
-      time_ = SDL_GetTicks();
-      dt = 0;
-    }
-  else
-    {
-      //Find the change in time
-      int newtime = SDL_GetTicks();
-      dt = newtime - time_;
-      time_ = newtime;
-    }
+  int dt = clock.dt();
 
   //Adjust the rotation amount
   rot_ += rotspeed_ * ((float)dt / 1000);
@@ -263,29 +234,18 @@ void Planet::update()
   for (unsigned int i = 0; i < building_.size(); i++)
     {
       //Update the building
-      building_[i].update();
+      building_[i].update(clock);
       
       //Skip over nonexistant and incomplete buildings
       if (!building_[i].exists() || i == Uint32(buildIndex_)) continue;
-      //Create a string stream and vector for tokens
-      std::stringstream ss(building_[i].effect());
-      std::string item;
-      std::vector<std::string> tokens;
-      while (std::getline(ss, item, ' '))
-	{
-	  tokens.push_back(item);
-	}
+      const BuildingEffect& effect = building_[i].effect();
 
       //Only go over effects to the planet itself, effects to other objects
-      //should be handled in main().
+      //should be handled by the GameWorld.
       
-      //Analyze it
       //Build ships: build <shiptype> <secondinterval>
-      if (tokens[0] == "build")
+      if (effect.type == EFFECT_BUILD)
 	{
-	  //Ensure size of 3
-	  if (tokens.size() != 3) continue;
-
 	  //Add to the ship count
           //Depleted volcanic planets produce at lower speed
           //and non-depleted should consume resources
@@ -293,9 +253,9 @@ void Planet::update()
             {
               if (typeInfo_ <= 0)
                 {
-                  float add = (float)dt/(atof(tokens[2].c_str()))/1000.0;
+                  float add = (float)dt/effect.interval/1000.0;
                   add *= PLANET1_DEPLETION_PENALTY;
-                  ship_[std::atoi(tokens[1].c_str())].first += add;
+                  ship_[effect.shipType].first += add;
                 }
               else
                 {
@@ -305,7 +265,7 @@ void Planet::update()
             }
           else
             {
-              ship_[std::atoi(tokens[1].c_str())].first += (float)dt/(atof(tokens[2].c_str()))/1000.0;
+              ship_[effect.shipType].first += (float)dt/effect.interval/1000.0;
             }
 	}
     }
@@ -358,7 +318,7 @@ void Planet::build(Building* inbuild, const std::vector<std::list<Building*> >&
   for (std::list<Building*>::const_iterator i = rules[type_].begin(); i != rules[type_].end(); i++)
     {
       //If the effects are the same
-      if (inbuild->effect() == (*i)->effect())
+      if (inbuild->effectString() == (*i)->effectString())
 	{
 	  //Build it
 	  build(inbuild);
@@ -500,14 +460,50 @@ void Planet::takeAttack(int inships, int type, int player, const std::vector<Shi
   defense.clear();
 }
 
-//Accesses the rotation at a given angle, or uses the current rotation
-SDL_Surface* Planet::rotation(float angle)
+//Returns the area, in world coordinates, that record() and the selection box may draw in
+//Buildings are counted as if rotated to face any direction
+SDL_Rect Planet::bounds() const
 {
-  if (angle < 0)
+  int w = rotation_.empty() ? 0 : rotation_->width();
+  int h = rotation_.empty() ? 0 : rotation_->height();
+  float radius = UNSCALED_PLANET_RADIUS * size_;
+
+  //The planet itself, and the selection box around it
+  float left = std::min(pos_.x(), pos_.x() - PLANET_SELECT_MARGIN);
+  float top = std::min(pos_.y(), pos_.y() - PLANET_SELECT_MARGIN);
+  float right = std::max(pos_.x() + w, pos_.x() + 2*radius + PLANET_SELECT_MARGIN);
+  float bottom = std::max(pos_.y() + h, pos_.y() + 2*radius + PLANET_SELECT_MARGIN);
+
+  //The ship count, centered on the bottom right of the radius
+  left = std::min(left, pos_.x() + radius - PLANET_COUNT_REACH_X);
+  top = std::min(top, pos_.y() + radius - PLANET_COUNT_REACH_Y);
+  right = std::max(right, pos_.x() + radius + PLANET_COUNT_REACH_X);
+  bottom = std::max(bottom, pos_.y() + radius + PLANET_COUNT_REACH_Y);
+
+  //The owner indicator
+  if (owner_ != 0 && !indicator_.empty())
     {
-      return rotation_.rotation(rot_);
+      left = std::min(left, pos_.x() - 6*size_);
+      top = std::min(top, pos_.y() - 6*size_);
+      right = std::max(right, pos_.x() - 6*size_ + indicator_.get()->w);
+      bottom = std::max(bottom, pos_.y() - 6*size_ + indicator_.get()->h);
     }
-  return rotation_.rotation(angle);
+
+  //The buildings around the edge
+  float cx = pos_.x() + w/2, cy = pos_.y() + h/2;
+  for (unsigned int i = 0; i < building_.size(); i++)
+    {
+      if (!building_[i].exists()) continue;
+      int bw = building_[i].width(), bh = building_[i].height();
+      float reach = radius + bh/5 + std::max(bw, bh);
+      left = std::min(left, cx - reach);
+      top = std::min(top, cy - reach);
+      right = std::max(right, cx + reach);
+      bottom = std::max(bottom, cy + reach);
+    }
+
+  SDL_Rect box = {Sint16(left), Sint16(top), Uint16(right - left + 1), Uint16(bottom - top + 1)};
+  return box;
 }
 
 //Returns a vector of ship counts
@@ -550,17 +546,15 @@ Vec2f Planet::buildcoords(int i)
 
   //Construct the coordinates
   float angle = (i * 2 * 3.14159265358979323 / building_.size()) + rot_;
-  float rad = (UNSCALED_PLANET_RADIUS * size_) + b.rotation(0)->h/5;
+  float rad = (UNSCALED_PLANET_RADIUS * size_) + b.height()/5;
 
-  return Vec2f((std::cos(angle) * rad) + pos_.x() + (rotation_.rotation(0)->w/2),
-	       (std::sin(angle) * rad) + pos_.y() + (rotation_.rotation(0)->h/2));
+  return Vec2f((std::cos(angle) * rad) + pos_.x() + (rotation_->width()/2),
+	       (std::sin(angle) * rad) + pos_.y() + (rotation_->height()/2));
 }
 
 void Planet::setImage(SDL_Surface* insurf)
 {
-  SDL_Surface* scaled = scaleNN(insurf, size_);
-  rotation_ = RotationCache(scaled, NUM_PLANET_ROTATIONS);
-  SDL_FreeSurface(scaled);
+  rotation_ = SharedRotation(insurf, imageScale(size_), NUM_PLANET_ROTATIONS, PLANET_ROTATION_FILTER);
 }
 
 //Sets the type and initializes typeInfo_
@@ -580,15 +574,13 @@ void Planet::setOwner(const int inowner, SDL_Surface* indicator[])
 {
   owner_ = inowner;
 
-  if (indicator_ != NULL) SDL_FreeSurface(indicator_);
-  
-  if (owner_ != 0)
+  if (owner_ != 0 && indicator != NULL && indicator[owner_] != NULL)
     {
-      indicator_ = scaleNN(indicator[owner_], size_);
+      indicator_ = SharedSurface(scaleNN(indicator[owner_], size_));
     }
   else
     {
-      indicator_ = NULL;
+      indicator_ = SharedSurface();
     }
 }
 
@@ -9,12 +9,14 @@
   Header for the Planet class in "Galcon".
 */
 
-#include "rotationcache.h"
+#include "rotationregistry.h"
+#include "sharedsurface.h"
+#include "renderlist.h"
 #include "SDL/SDL.h"
-#include "SDL/SDL_ttf.h"
 #include "buildingInstance.h"
 #include "vec2f.h"
 #include "shipstats.h"
+#include "simclock.h"
 #include <vector>
 #include <map>
 #include <list>
@@ -22,9 +24,24 @@
 #ifndef _planet_h_
 #define _planet_h_
 
-const int NUM_PLANET_ROTATIONS = 500;
+//Bilinear rotations look smooth with far fewer of them stored
+const int NUM_PLANET_ROTATIONS = 128;
+const RotationFilter PLANET_ROTATION_FILTER = ROTATION_BILINEAR;
 const int UNSCALED_PLANET_RADIUS = 50;
 
+//Color of the ship count drawn on each planet
+const SDL_Color PLANET_COUNT_COLOR = {0, 255, 255};
+
+//How far the selection box reaches past the planet
+const int PLANET_SELECT_MARGIN = 10;
+
+//Half the width of the widest ship count, and half its height
+const int PLANET_COUNT_REACH_X = 40;
+const int PLANET_COUNT_REACH_Y = 20;
+
+//Planet images are scaled in steps of this much, so similar planets share rotations
+const float PLANET_IMAGE_SCALE_STEP = 0.04;
+
 const float PLANET1_FUEL_PER_SIZE = 240000;
 const float PLANET1_DEPLETION_RATE = 1000;
 const float PLANET1_DEPLETION_PENALTY = .5;
@@ -34,14 +51,14 @@ const float PLANET_DAMAGE_MULT[2] = {1,1.3};
 class Planet
 {
  public:
-  //Constructors/Destructor
+  //Constructors
+  //Copies share the rotations and indicator of the original
   Planet();
   Planet(SDL_Surface* surf, float size, Vec2f loc, int type);
-  ~Planet();
 
   //Regular use functions
-  void display(SDL_Surface* screen, TTF_Font* font, const SDL_Rect& camera);
-  void update();
+  void record(RenderList& list, int dt) const;
+  void update(const SimClock& clock);
   bool canBuild();
   void build(Building* inbuild);
   void build(Building* inbuild, const std::vector<std::list<Building*> >& rules);
@@ -49,9 +66,9 @@ class Planet
   void addShips(int inships, int type);
   int splitShips(float ratio, int type);
   void takeAttack(int inships, int type, int player, const std::vector<ShipStats>& shipstats, SDL_Surface* indicator[]);
+  void precache() {if (!rotation_.empty()) rotation_->precacheAsync();}
 
   //Accessors
-  SDL_Surface* rotation(float angle = -1);
   Vec2f pos() const {return pos_;}
   Vec2f center() const {Vec2f c = pos()+Vec2f(UNSCALED_PLANET_RADIUS,UNSCALED_PLANET_RADIUS); return c;}
   double x() const {return pos_.x();}
@@ -70,6 +87,14 @@ class Planet
   float totalAttack(const std::vector<ShipStats>& shipstats) const;
   float totalDefense(const std::vector<ShipStats>& shipstats) const;
   int typeInfo() const {return typeInfo_;}
+  int index() const {return index_;}
+  int incomingShips(int player, int type) const;
+  int incomingPlayers() const {return incoming_.size();}
+
+  //The area, in world coordinates, that record() and the selection box may draw in
+  SDL_Rect bounds() const;
+  float incomingAttack(int player, const std::vector<ShipStats>& shipstats) const;
+  float incomingDefense(int player, const std::vector<ShipStats>& shipstats) const;
 
   //Mutators
   void setImage(SDL_Surface* insurf);
@@ -80,10 +105,15 @@ class Planet
   void setShipRate(int index, float rate) {ship_[index].second = rate * size_;}
   void setDifficulty(int diff) {if (owner_==0) ship_[0].first = diff;}
   void setTypeInfo(int ti) {typeInfo_ = ti;}
+  void setIndex(int index) {index_ = index;}
+
+  //Keeps count of the ships in fleets headed here
+  //FleetStore calls this whenever a fleet is launched, loses ships or is removed
+  void addIncoming(int player, int type, int ships);
 
  private:
-  //Stores the rotations of the planet
-  RotationCache rotation_;
+  //Stores the rotations of the planet, shared with identical planets
+  SharedRotation rotation_;
 
   //Current rotation, in radians
   float rot_;
@@ -97,9 +127,6 @@ class Planet
   //Size of the planet as a scalar amount from the base
   float size_;
 
-  //Time of last progress() call
-  int time_;
-
   //Type of planet
   unsigned char type_;
   
@@ -115,20 +142,20 @@ class Planet
   //Vector of pairs of ship counts and build rates, respectively
   std::vector<std::pair<float, float> > ship_;
 
-  //The surface with text showing the total number of ships
-  SDL_Surface* countImg_;
-
-  //The actual number from last time
-  int count_;
-
   //The number for the player who owns the planet
   int owner_;
 
   //The surface for the scaled owner indicator
-  SDL_Surface* indicator_;
+  SharedSurface indicator_;
 
   //Variable for keeping track of type-specific information
   int typeInfo_;
+
+  //Position of the planet in the PlanetMap, -1 until the map is built
+  int index_;
+
+  //Ships of each type in fleets headed here, indexed by owner and then type
+  std::vector<std::vector<int> > incoming_;
 };
   
 typedef std::list<Planet>::iterator planetIter;
@@ -0,0 +1,178 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----PlanetMap Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the PlanetMap class.
+*/
+
+#ifndef _planetmap_cpp_
+#define _planetmap_cpp_
+
+#include "planetmap.h"
+#include <algorithm>
+
+//Orders planet indices by their distance from one planet
+class CloserTo
+{
+ public:
+  CloserTo(const float* row):row_(row) {}
+  bool operator()(int a, int b) const {return row_[a] < row_[b];}
+ private:
+  const float* row_;
+};
+
+//Default constructor, the map starts out empty
+PlanetMap::PlanetMap():
+  left_(0),
+  top_(0),
+  columns_(0),
+  rows_(0),
+  reach_(0)
+{}
+
+//Numbers the planets and finds the distances between them
+void PlanetMap::build(std::list<Planet>& planets, const std::vector<ShipStats>& shipstats)
+{
+  //Number the planets in list order
+  planets_.clear();
+  for (planetIter i = planets.begin(); i != planets.end(); i++)
+    {
+      i->setIndex(planets_.size());
+      planets_.push_back(&(*i));
+    }
+  unsigned int n = planets_.size();
+  nearest_.clear();
+  columns_ = rows_ = 0;
+  if (n == 0) return;
+
+  //Find the true center of each planet
+  std::vector<Vec2f> center(n);
+  for (unsigned int i = 0; i < n; i++)
+    {
+      float radius = UNSCALED_PLANET_RADIUS * planets_[i]->size();
+      center[i] = planets_[i]->pos() + Vec2f(radius, radius);
+    }
+
+  //Fill in the distances, which are symmetric
+  dist_.assign(n*n, 0);
+  for (unsigned int a = 0; a < n; a++)
+    {
+      for (unsigned int b = a+1; b < n; b++)
+	{
+	  dist_[a*n + b] = dist_[b*n + a] = center[a].distance(center[b]);
+	}
+    }
+
+  //A fleet arrives once it is within the radius of its destination
+  travel_.assign(shipstats.size()*n*n, 0);
+  for (unsigned int t = 0; t < shipstats.size(); t++)
+    {
+      for (unsigned int a = 0; a < n; a++)
+	{
+	  for (unsigned int b = 0; b < n; b++)
+	    {
+	      if (a == b) continue;
+	      float flight = distance(a, b) - UNSCALED_PLANET_RADIUS * planets_[b]->size();
+	      travel_[(t*n + a)*n + b] = std::max(flight, 0.0f) / shipstats[t].speed;
+	    }
+	}
+    }
+
+  //Sort each planet's neighbours by distance
+  nearest_.reserve(n*(n-1));
+  for (unsigned int a = 0; a < n; a++)
+    {
+      for (unsigned int b = 0; b < n; b++)
+	{
+	  if (a != b) nearest_.push_back(b);
+	}
+      std::sort(nearest_.begin() + a*(n-1), nearest_.end(), CloserTo(&dist_[a*n]));
+    }
+
+  //Find where each planet draws, leaving room for buildings
+  std::vector<double> gx(n), gy(n);
+  reach_ = 0;
+  double right = 0, bottom = 0;
+  for (unsigned int i = 0; i < n; i++)
+    {
+      SDL_Rect b = planets_[i]->bounds();
+      gx[i] = b.x + b.w / 2.0;
+      gy[i] = b.y + b.h / 2.0;
+      reach_ = std::max(reach_, std::max(b.w, b.h) / 2.0f + PLANET_MAP_BUILDING_REACH);
+      if (i == 0 || gx[i] < left_) left_ = gx[i];
+      if (i == 0 || gy[i] < top_) top_ = gy[i];
+      if (i == 0 || gx[i] > right) right = gx[i];
+      if (i == 0 || gy[i] > bottom) bottom = gy[i];
+    }
+  columns_ = int((right - left_) / PLANET_MAP_CELL_SIZE) + 1;
+  rows_ = int((bottom - top_) / PLANET_MAP_CELL_SIZE) + 1;
+
+  //Count the planets in each cell, then turn the counts into starting offsets
+  std::vector<int> cell(n);
+  start_.assign(columns_ * rows_ + 1, 0);
+  for (unsigned int i = 0; i < n; i++)
+    {
+      cell[i] = row(gy[i]) * columns_ + column(gx[i]);
+      start_[cell[i] + 1]++;
+    }
+  for (unsigned int c = 1; c < start_.size(); c++)
+    {
+      start_[c] += start_[c-1];
+    }
+
+  //Place each planet in its cell
+  std::vector<int> next(start_.begin(), start_.end() - 1);
+  cells_.resize(n);
+  for (unsigned int i = 0; i < n; i++)
+    {
+      cells_[next[cell[i]]++] = i;
+    }
+}
+
+//Appends the index of every planet that may draw inside area, in increasing order
+void PlanetMap::visible(const SDL_Rect& area, std::vector<int>& out) const
+{
+  if (columns_ == 0) return;
+
+  //A planet can draw up to reach_ from its center, so look that much further out
+  double x1 = area.x - reach_, y1 = area.y - reach_;
+  double x2 = area.x + area.w + reach_, y2 = area.y + area.h + reach_;
+  if (x2 < left_ || y2 < top_ ||
+      x1 > left_ + columns_ * PLANET_MAP_CELL_SIZE ||
+      y1 > top_ + rows_ * PLANET_MAP_CELL_SIZE) return;
+
+  unsigned int first = out.size();
+  int c1 = column(x1), c2 = column(x2);
+  for (int r = row(y1); r <= row(y2); r++)
+    {
+      out.insert(out.end(), cells_.begin() + start_[r * columns_ + c1],
+		 cells_.begin() + start_[r * columns_ + c2 + 1]);
+    }
+
+  //Keep the planets in the order they are always drawn in
+  std::sort(out.begin() + first, out.end());
+}
+
+//Finds the column containing an x coordinate, clamped to the grid
+int PlanetMap::column(double x) const
+{
+  int c = int((x - left_) / PLANET_MAP_CELL_SIZE);
+  if (c < 0) return 0;
+  if (c >= columns_) return columns_ - 1;
+  return c;
+}
+
+//Finds the row containing a y coordinate, clamped to the grid
+int PlanetMap::row(double y) const
+{
+  int r = int((y - top_) / PLANET_MAP_CELL_SIZE);
+  if (r < 0) return 0;
+  if (r >= rows_) return rows_ - 1;
+  return r;
+}
+
+#endif
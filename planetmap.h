@@ -0,0 +1,94 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----PlanetMap Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Distances between every pair of planets, found once after the map is
+  generated. Planets never move, so the AI and anything else that needs
+  distances can look them up instead of working them out again.
+
+  Planets are referred to by Planet::index(), which build() assigns.
+
+  The planets are also sorted into a coarse grid, so the ones that might be
+  on screen can be found without checking every planet.
+*/
+
+#ifndef _planetmap_h_
+#define _planetmap_h_
+
+#include <list>
+#include <vector>
+#include "SDL/SDL.h"
+#include "planet.h"
+#include "shipstats.h"
+
+//Side length of the grid cells planets are sorted into
+const float PLANET_MAP_CELL_SIZE = 256;
+
+//Extra room left around each planet in the grid, for buildings added later
+const int PLANET_MAP_BUILDING_REACH = 2 * BUILDING_WIDTH;
+
+class PlanetMap
+{
+ public:
+  //Constructors
+  PlanetMap();
+
+  //Numbers the planets and finds the distances between them
+  //The planets must not be added to or removed from afterwards
+  void build(std::list<Planet>& planets, const std::vector<ShipStats>& shipstats);
+
+  //Accessors
+  unsigned int size() const {return planets_.size();}
+  Planet* planet(int i) const {return planets_[i];}
+
+  //Distance between the centers of two planets
+  float distance(int a, int b) const {return dist_[a*size() + b];}
+  float distance(const Planet* a, const Planet* b) const {return distance(a->index(), b->index());}
+
+  //Time in seconds for a fleet of the given type to fly from a until it reaches b
+  float travelTime(int a, int b, int type) const {return travel_[(type*size() + a)*size() + b];}
+
+  //The other planets, sorted from nearest to furthest from planet i
+  //There are size()-1 of them
+  const int* nearest(int i) const {return nearest_.empty() ? NULL : &nearest_[i*(size()-1)];}
+
+  //Appends the index of every planet that may draw inside area, in increasing order
+  //Planets that only come close may be included, so check their bounds() too
+  void visible(const SDL_Rect& area, std::vector<int>& out) const;
+
+ private:
+  //Finds the column or row containing a coordinate, clamped to the grid
+  int column(double x) const;
+  int row(double y) const;
+
+  //Every planet, by index
+  std::vector<Planet*> planets_;
+
+  //Distances and travel times, each row is one starting planet
+  //travel_ has a block of rows for each ship type
+  std::vector<float> dist_;
+  std::vector<float> travel_;
+
+  //Each planet's neighbours, size()-1 per planet, nearest first
+  std::vector<int> nearest_;
+
+  //The grid, with its top left corner and number of cells in each direction
+  //Each planet is placed in the cell holding the center of its bounds
+  double left_;
+  double top_;
+  int columns_;
+  int rows_;
+
+  //Where each cell's planets begin in cells_, with one extra entry at the end
+  std::vector<int> start_;
+  std::vector<int> cells_;
+
+  //The furthest any planet draws from the center of its bounds
+  float reach_;
+};
+
+#endif
@@ -1,7 +1,7 @@
 /*
   Copyright (c) 2013 Auston Sterling
   See license.txt for copying permission.
-  
+
   -----Projectile Class Declaration-----
   Auston Sterling
   austonst@gmail.com
@@ -12,9 +12,12 @@
 #ifndef _projectile_h_
 #define _projectile_h_
 
-#include <string>
-#include "fleet.h"
+#include <vector>
+#include "SDL/SDL.h"
+#include "fleetid.h"
 #include "vec2f.h"
+#include "simclock.h"
+#include "payload.h"
 
 const int DEFAULT_PROJECTILE_SPEED = 200;
 
@@ -23,37 +26,40 @@ class Projectile
  public:
   //Constructors
   Projectile();
-  Projectile(Vec2f start, Fleet* dest, std::string effect, float speed);
+  Projectile(Vec2f start, FleetId dest, Payload payload, float speed);
 
   //Accessors
   Vec2f pos() const {return pos_;}
+  Vec2f moved() const {return moved_;}
   double x() const {return pos_.x();}
   double y() const {return pos_.y();}
-  Fleet* target() {return target_;}
-  std::string effect() const {return effect_;}
+  FleetId target() const {return target_;}
+  const Payload& payload() const {return payload_;}
+  bool expired() const {return target_ == NO_FLEET;}
 
   //General use functions
-  void update();
-  void display(SDL_Surface* screen, const SDL_Rect& camera);
-  
+  void update(const SimClock& clock, Vec2f target);
+  void expire() {target_ = NO_FLEET;}
+
  private:
   //Current coordinates of the projectile
   Vec2f pos_;
 
-  //Target fleet
-  Fleet* target_;
+  //How far the projectile moved in its last update
+  Vec2f moved_;
+
+  //Target fleet, NO_FLEET once the projectile is spent
+  //The fleet may have been destroyed since, so check it with the FleetStore
+  FleetId target_;
 
   //The speed, in pixels per second
   int speed_;
 
-  //The effect as a parsable string
-  std::string effect_;
-
-  //The ticks at the last time update was called
-  int lastTicks_;
+  //What the projectile does when it hits
+  Payload payload_;
 };
 
-typedef std::list<Projectile>::iterator projectileIter;
-typedef std::list<Projectile>::const_iterator projectileIterConst;
+typedef std::vector<Projectile>::iterator projectileIter;
+typedef std::vector<Projectile>::const_iterator projectileIterConst;
 
 #endif
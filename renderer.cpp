@@ -0,0 +1,129 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Renderer Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Contains the implementation of the Renderer class, which draws RenderLists.
+*/
+
+#ifndef _renderer_cpp_
+#define _renderer_cpp_
+
+#include "renderer.h"
+#include "glyphatlas.h"
+#include <algorithm>
+
+//Checks whether a rectangle in screen coordinates overlaps a camera's view
+static inline bool onScreen(const SDL_Rect& camera, int x, int y, int w, int h)
+{
+  return x < camera.w && y < camera.h && x + w > 0 && y + h > 0;
+}
+
+//Constructor
+Renderer::Renderer(SDL_Surface* screen, TTF_Font* font) :
+  screen_(screen),
+  font_(font),
+  linedraw_(screen)
+{
+  linedraw_.setMode(LINE_ANTIALIASED);
+}
+
+//Draws list as the world was alpha of the way through its tick
+void Renderer::draw(const RenderList& list, float alpha, const SDL_Rect& camera, DirtyRects& dirty)
+{
+  //Everything is drawn where it was at the last tick, moved on by alpha of its movement since
+  float back = 1 - alpha;
+
+  //Runs of beams are drawn under one lock of the screen, which blits need unlocked
+  bool beams = false;
+
+  for (unsigned int i = 0; i < list.size(); i++)
+    {
+      const RenderCommand& c = list[i];
+      if (beams && c.kind != RENDER_BEAM)
+	{
+	  linedraw_.end();
+	  beams = false;
+	}
+
+      //Find where on the screen it is
+      int x = c.x - c.dx * back - camera.x;
+      int y = c.y - c.dy * back - camera.y;
+
+      switch (c.kind)
+	{
+	case RENDER_SPRITE:
+	  {
+	    RotationCache* rotation = list.rotation(c.sprite);
+	    if (!onScreen(camera, x, y, rotation->width(), rotation->height())) break;
+	    float angle = (c.angle - c.spin * back) * (2 * 3.14159265358979323 / RENDER_TURN);
+	    SDL_Rect outrect = {Sint16(x), Sint16(y), 0, 0};
+	    RotationFrame f = rotation->blit(angle, screen_, &outrect);
+	    dirty.mark(x, y, f.rect.w, f.rect.h, f.surface, f.rect.y);
+	    break;
+	  }
+
+	case RENDER_IMAGE:
+	  {
+	    SDL_Surface* image = list.image(c.sprite);
+	    if (!onScreen(camera, x, y, image->w, image->h)) break;
+	    SDL_Rect outrect = {Sint16(x), Sint16(y), 0, 0};
+	    dirty.mark(x, y, image->w, image->h, image, 0);
+	    SDL_BlitSurface(image, NULL, screen_, &outrect);
+	    break;
+	  }
+
+	case RENDER_BOX:
+	  {
+	    if (!onScreen(camera, x, y, c.w, c.h)) break;
+	    SDL_Rect rect = {Sint16(x), Sint16(y), c.w, c.h};
+	    dirty.mark(rect, NULL, c.color);
+	    SDL_FillRect(screen_, &rect, SDL_MapRGB(screen_->format, c.color >> 16, c.color >> 8 & 255, c.color & 255));
+	    break;
+	  }
+
+	case RENDER_COUNT:
+	  {
+	    //Blit the digits out of the font's shared atlas
+	    SDL_Color color = {Uint8(c.color >> 16), Uint8(c.color >> 8), Uint8(c.color)};
+	    GlyphAtlas& digits = GlyphAtlas::get(font_, color);
+	    int w = digits.width(c.value);
+	    x = c.x - (w/2) - camera.x;
+	    y = c.y - (digits.height()/2) - camera.y;
+	    if (!onScreen(camera, x, y, w, digits.height())) break;
+	    dirty.mark(x, y, w, digits.height(), &digits, Uint32(c.value));
+	    digits.draw(c.value, screen_, x, y);
+	    break;
+	  }
+
+	case RENDER_BEAM:
+	  {
+	    //Beams don't move, so they are placed by their ends alone
+	    Vec2f from(c.x - camera.x, c.y - camera.y);
+	    Vec2f to = from + Vec2f(c.dx, c.dy);
+	    int x1 = std::min(from.x(), to.x()), y1 = std::min(from.y(), to.y());
+	    int x2 = std::max(from.x(), to.x()), y2 = std::max(from.y(), to.y());
+	    if (!onScreen(camera, x1, y1, x2 - x1 + 1, y2 - y1 + 1)) break;
+
+	    //Lines with the same bounds can still run corner to corner either way, or
+	    //fade the other way, so the variant records which way each one goes
+	    //Anti-aliased lines can shade a pixel past their ends on any side
+	    Uint32 direction = (c.dx >= 0) | ((c.dy >= 0) << 1);
+	    dirty.mark(x1 - 1, y1 - 1, x2 - x1 + 3, y2 - y1 + 3, NULL, direction);
+	    if (!beams)
+	      {
+		linedraw_.begin();
+		beams = true;
+	      }
+	    linedraw_.line(from, to, BEAM_START_COLOR, BEAM_END_COLOR);
+	    break;
+	  }
+	}
+    }
+  if (beams) linedraw_.end();
+}
+
+#endif
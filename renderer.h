@@ -0,0 +1,52 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Renderer Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Draws RenderLists recorded by the simulation. A list is drawn as the world
+  was some fraction of the way through its tick, so motion stays smooth when
+  frames don't line up with simulation steps.
+
+  Lists must be recorded and drawn on the same thread, the one that calls
+  RotationRegistry::update. Recording copies sprite and rotation references,
+  whose counts aren't locked, and drawing looks up and stamps rotations in the
+  caches that update may evict from.
+*/
+
+#ifndef _renderer_h_
+#define _renderer_h_
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#include "renderlist.h"
+#include "lineDrawer.h"
+#include "dirtyrects.h"
+
+//Interception beams fade from the first color at the attacker to the second at the target
+const SDL_Color BEAM_START_COLOR = {255, 255, 0};
+const SDL_Color BEAM_END_COLOR = {255, 0, 0};
+
+class Renderer
+{
+ public:
+  //Constructors
+  //Numbers are drawn in font, which must outlive the renderer
+  Renderer(SDL_Surface* screen, TTF_Font* font);
+
+  //Draws list as the world was alpha of the way through its tick, from 0 to 1
+  //Only things inside camera are drawn, and everything drawn is marked in dirty
+  void draw(const RenderList& list, float alpha, const SDL_Rect& camera, DirtyRects& dirty);
+
+ private:
+  //The surface drawn to, and the font numbers are drawn in
+  SDL_Surface* screen_;
+  TTF_Font* font_;
+
+  //Draws the beams, anti-aliased
+  LineDrawer linedraw_;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----RenderList Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Contains the implementation of the RenderList class, a list of what to draw
+  for one simulation tick.
+*/
+
+#ifndef _renderlist_cpp_
+#define _renderlist_cpp_
+
+#include "renderlist.h"
+#include <cmath>
+
+//Converts radians to steps of a turn, rounded to the nearest
+static long turnSteps(float radians)
+{
+  return std::floor(radians * (RENDER_TURN / (2 * 3.14159265358979323)) + 0.5);
+}
+
+//Default constructor
+RenderList::RenderList()
+{}
+
+//Empties the list for another tick
+void RenderList::clear()
+{
+  commands_.clear();
+  sprites_.clear();
+  spriteIndex_.clear();
+}
+
+//Adds a rotation of a sprite, which turned by spin and moved by moved during the tick
+void RenderList::sprite(const SharedRotation& rotation, float angle, float spin, Vec2f pos, Vec2f moved)
+{
+  RenderCommand& c = add(RENDER_SPRITE);
+  c.sprite = spriteIndex(rotation);
+  c.angle = Uint16(turnSteps(angle) & (RENDER_TURN - 1));
+  c.spin = Sint16(turnSteps(spin));
+  c.x = pos.x();
+  c.y = pos.y();
+  c.dx = moved.x();
+  c.dy = moved.y();
+}
+
+//Adds a whole image, which doesn't move
+void RenderList::image(const SharedSurface& image, Vec2f pos)
+{
+  RenderCommand& c = add(RENDER_IMAGE);
+  c.sprite = spriteIndex(image);
+  c.x = pos.x();
+  c.y = pos.y();
+}
+
+//Adds a solid box of color, which moved by moved during the tick
+void RenderList::box(Vec2f pos, Vec2f moved, int w, int h, Uint32 color)
+{
+  RenderCommand& c = add(RENDER_BOX);
+  c.w = w;
+  c.h = h;
+  c.color = color;
+  c.x = pos.x();
+  c.y = pos.y();
+  c.dx = moved.x();
+  c.dy = moved.y();
+}
+
+//Adds a number centered on center
+void RenderList::count(int value, Vec2f center, SDL_Color color)
+{
+  RenderCommand& c = add(RENDER_COUNT);
+  c.value = value;
+  c.color = (Uint32(color.r) << 16) | (Uint32(color.g) << 8) | color.b;
+  c.x = center.x();
+  c.y = center.y();
+}
+
+//Adds an interception beam
+void RenderList::beam(Vec2f from, Vec2f to)
+{
+  RenderCommand& c = add(RENDER_BEAM);
+  c.x = from.x();
+  c.y = from.y();
+  c.dx = to.x() - from.x();
+  c.dy = to.y() - from.y();
+}
+
+//Trades contents with another list
+void RenderList::swap(RenderList& other)
+{
+  commands_.swap(other.commands_);
+  sprites_.swap(other.sprites_);
+  spriteIndex_.swap(other.spriteIndex_);
+}
+
+//Starts a command with everything but its kind zeroed
+RenderCommand& RenderList::add(RenderKind kind)
+{
+  RenderCommand c = {};
+  c.kind = kind;
+  commands_.push_back(c);
+  return commands_.back();
+}
+
+//Finds the index of a rotation, adding it the first time it's used
+Uint16 RenderList::spriteIndex(const SharedRotation& rotation)
+{
+  std::map<const void*, Uint16>::iterator i = spriteIndex_.find(rotation.get());
+  if (i != spriteIndex_.end()) return i->second;
+
+  sprites_.push_back(Sprite());
+  sprites_.back().rotation = rotation;
+  spriteIndex_[rotation.get()] = sprites_.size() - 1;
+  return sprites_.size() - 1;
+}
+
+//Finds the index of an image, adding it the first time it's used
+Uint16 RenderList::spriteIndex(const SharedSurface& image)
+{
+  std::map<const void*, Uint16>::iterator i = spriteIndex_.find(image.get());
+  if (i != spriteIndex_.end()) return i->second;
+
+  sprites_.push_back(Sprite());
+  sprites_.back().image = image;
+  spriteIndex_[image.get()] = sprites_.size() - 1;
+  return sprites_.size() - 1;
+}
+
+#endif
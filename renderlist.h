@@ -0,0 +1,121 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----RenderList Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  A compact list of what to draw for one simulation tick. The simulation
+  records a list after stepping, and a Renderer draws it as many times as it
+  likes, at whatever rate it likes, without looking at the simulation again.
+
+  Every command holds where its object is at this tick and how far it moved
+  or turned during it, so the renderer can place it anywhere between the last
+  two ticks. Sprites are referred to by an index into the list's own table,
+  which holds a reference to each one, so a list stays valid however the
+  world changes after it was recorded.
+
+  Positions are in world coordinates. Angles are in 1/RENDER_TURN of a turn.
+*/
+
+#ifndef _renderlist_h_
+#define _renderlist_h_
+
+#include "SDL/SDL.h"
+#include "rotationregistry.h"
+#include "sharedsurface.h"
+#include "vec2f.h"
+#include <vector>
+#include <map>
+
+//The number of angle steps in a full turn
+const int RENDER_TURN = 65536;
+
+//What a command draws
+enum RenderKind
+{
+  RENDER_SPRITE,  //A rotation of a sprite, by its top left corner
+  RENDER_IMAGE,   //A whole image, by its top left corner
+  RENDER_BOX,     //A solid box
+  RENDER_COUNT,   //A number from the digit atlas, centered
+  RENDER_BEAM     //An interception beam, from attacker to target
+};
+
+struct RenderCommand
+{
+  //One of the RENDER_ kinds
+  Uint8 kind;
+
+  //Which of the list's sprites or images to draw
+  Uint16 sprite;
+
+  //Rotation of a sprite at this tick, and how far it turned during it
+  Uint16 angle;
+  Sint16 spin;
+
+  //Size of a box
+  Uint16 w, h;
+
+  //The number drawn by a count
+  Sint32 value;
+
+  //Color of a box or count, as 0xRRGGBB
+  Uint32 color;
+
+  //Position at this tick, and how far it moved during it
+  //Beams run from (x, y) to (x+dx, y+dy) and are never moved
+  float x, y;
+  float dx, dy;
+};
+
+class RenderList
+{
+ public:
+  //Constructors
+  RenderList();
+
+  //Empties the list for another tick, keeping its memory
+  void clear();
+
+  //Recording commands, drawn in the order they are added
+  //Angles and spins are in radians
+  void sprite(const SharedRotation& rotation, float angle, float spin, Vec2f pos, Vec2f moved);
+  void image(const SharedSurface& image, Vec2f pos);
+  void box(Vec2f pos, Vec2f moved, int w, int h, Uint32 color);
+  void count(int value, Vec2f center, SDL_Color color);
+  void beam(Vec2f from, Vec2f to);
+
+  //Accessors
+  unsigned int size() const {return commands_.size();}
+  const RenderCommand& operator[](unsigned int i) const {return commands_[i];}
+  RotationCache* rotation(int sprite) const {return sprites_[sprite].rotation.get();}
+  SDL_Surface* image(int sprite) const {return sprites_[sprite].image.get();}
+
+  //Trades contents with another list, for handing lists between the simulation and renderer
+  void swap(RenderList& other);
+
+ private:
+  //Something drawn by index, holding a reference so it outlives the simulation's use of it
+  struct Sprite
+  {
+    SharedRotation rotation;
+    SharedSurface image;
+  };
+
+  //Starts a command of the given kind at the end of the list
+  RenderCommand& add(RenderKind kind);
+
+  //Finds the index of a rotation or image, adding it the first time it's used
+  Uint16 spriteIndex(const SharedRotation& rotation);
+  Uint16 spriteIndex(const SharedSurface& image);
+
+  //The commands, in drawing order
+  std::vector<RenderCommand> commands_;
+
+  //The sprites commands refer to, and the index of each by address
+  std::vector<Sprite> sprites_;
+  std::map<const void*, Uint16> spriteIndex_;
+};
+
+#endif
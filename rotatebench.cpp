@@ -0,0 +1,76 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Rotation Benchmark-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Times the portable rotation kernels against the ones picked for this CPU,
+  and checks that both give exactly the same pixels. Build with "make bench".
+*/
+
+//The kernels are private to the cache, so take them straight from its source
+#include "rotationcache.cpp"
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+const int BENCH_SIZE = 200;
+const int BENCH_ROTATIONS = 500;
+
+//The angle of rotation number i
+static float benchAngle(int i)
+{
+  return wrapAngle(2 * rotatePi * i / BENCH_ROTATIONS);
+}
+
+//Rotates the image BENCH_ROTATIONS times, returning the seconds taken
+static double run(RotateKernel kernel, const std::vector<Uint32>& in)
+{
+  std::vector<Uint32> out(in.size());
+  std::clock_t start = std::clock();
+  for (int i = 0; i < BENCH_ROTATIONS; i++)
+    {
+      rotateWith(kernel, &in[0], &out[0], BENCH_SIZE, BENCH_SIZE, benchAngle(i), ROTATION_BACKGROUND_COLOR);
+    }
+  return double(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+//Times one filter both ways, then checks every rotation matches
+static bool compare(const char* name, RotateKernel portable, RotateKernel chosen, const std::vector<Uint32>& in)
+{
+  double ta = run(portable, in);
+  double tb = run(chosen, in);
+
+  bool same = true;
+  std::vector<Uint32> a(in.size()), b(in.size());
+  for (int i = 0; i < BENCH_ROTATIONS && same; i++)
+    {
+      rotateWith(portable, &in[0], &a[0], BENCH_SIZE, BENCH_SIZE, benchAngle(i), ROTATION_BACKGROUND_COLOR);
+      rotateWith(chosen, &in[0], &b[0], BENCH_SIZE, BENCH_SIZE, benchAngle(i), ROTATION_BACKGROUND_COLOR);
+      same = (a == b);
+    }
+
+  std::cout << name << ": scalar " << ta << "s, selected " << tb << "s";
+  if (chosen == portable) std::cout << " (no SIMD kernel for this CPU)";
+  else if (tb > 0) std::cout << ", " << ta / tb << "x faster";
+  std::cout << (same ? ", identical" : ", OUTPUTS DIFFER") << std::endl;
+  return same;
+}
+
+int main(int argc, char** argv)
+{
+  //A random image, with some of the background color mixed in
+  std::vector<Uint32> in(BENCH_SIZE * BENCH_SIZE);
+  std::srand(1);
+  for (unsigned int i = 0; i < in.size(); i++)
+    {
+      in[i] = (std::rand() % 8 == 0) ? ROTATION_BACKGROUND_COLOR : (Uint32(std::rand()) & 0xFFFFFF);
+    }
+
+  std::cout << BENCH_ROTATIONS << " rotations of a " << BENCH_SIZE << "x" << BENCH_SIZE << " image" << std::endl;
+  bool ok = compare("nearest", rotateRowsScalar, rotateKernel(ROTATION_NEAREST), in);
+  ok = compare("bilinear", rotateRowsBilinearScalar, rotateKernel(ROTATION_BILINEAR), in) && ok;
+  return ok ? 0 : 1;
+}
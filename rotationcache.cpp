@@ -7,77 +7,635 @@
   austonst@gmail.com
 
   Contains the implementation of the RotationCache class.
-  This is the non-threaded version, fully compatible with C++03.
+  Rotations can be precached asynchronously on the shared ThreadPool; each
+  slot's state is atomic, so a frame is only read once it is marked ready.
 */
 #ifndef _rotationcache_cpp_
 #define _rotationcache_cpp_
 
 #include "rotationcache.h"
+#include "threadpool.h"
 #include "SDL/SDL.h"
 
 #include <cmath> //REMOVE ONCE EXTERNAL ROTATION
+#include <vector>
+#include <cstdio>
+#include <cstring>
 
-//Default constructor, very bad!
-RotationCache::RotationCache()
+#if defined(__unix__) || defined(__APPLE__)
+#define ROTATION_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ROTATION_X86 1
+#include <immintrin.h>
+#endif
+
+//The states a slot in the cache can be in
+const char SLOT_EMPTY = 0;   //Not computed, nobody is working on it
+const char SLOT_QUEUED = 1;  //Waiting in the thread pool
+const char SLOT_CLAIMED = 2; //Being computed right now
+const char SLOT_READY = 3;   //Computed, the frame may be read
+
+unsigned int RotationCache::frame_ = 0;
+
+//The start of an atlas file. The frames follow, each pitch*h bytes
+//The header is padded so the pixels start aligned
+struct AtlasHeader
 {
-  size_ = 1;
-  interval_ = 2 * rotatePi;
-  SDL_Surface* temp = SDL_CreateRGBSurface(SDL_SWSURFACE, 5, 5, 32, 0, 0, 0, 0);
-  rotation_ = &temp;
+  char magic[4];
+  Uint32 version;
+  Uint32 w, h, pitch, count;
+  Uint32 filter;
+  char padding[36];
+};
+
+//Rotates every output row using per-column products from a table
+//ax and cx hold rm[0]*x and rm[2]*x for each column, by and dy hold rm[1]*y
+//and rm[3]*y for each row. Every kernel adds the same two floats and truncates,
+//so the output is bit-identical to multiplying the matrix out per pixel.
+//Stepping by adding a per-pixel delta would round differently, so don't.
+typedef void (*RotateKernel)(const Uint32* in, Uint32* out, int w, int h,
+			     const float* ax, const float* cx,
+			     const float* by, const float* dy, Uint32 color);
+
+//Portable version, one pixel at a time
+static void rotateRowsScalar(const Uint32* in, Uint32* out, int w, int h,
+			     const float* ax, const float* cx,
+			     const float* by, const float* dy, Uint32 color)
+{
+  int halfw = w / 2;
+  int halfh = h / 2;
+  for (int r = 0; r < h; r++)
+    {
+      Uint32* row = out + r * w;
+      for (int c = 0; c < w; c++)
+	{
+	  int x2 = int(ax[c] + by[r]) + halfw;
+	  int y2 = halfh - int(cx[c] + dy[r]);
+	  if ((x2 > -1) && (x2 < w) && (y2 > -1) && (y2 < h))
+	    {
+	      row[c] = in[(y2 * w) + x2];
+	    }
+	  else
+	    {
+	      row[c] = color;
+	    }
+	}
+    }
 }
 
-//Regular constructor
-//Takes in a pointer to a SDL_Surface and the size of the array
-//This is essentially a modified resize
-RotationCache::RotationCache(SDL_Surface* surf, int insize)
+#ifdef ROTATION_X86
+//SSE2 version, finds the source coordinates four at a time
+//SSE2 has no gather, so the pixels themselves are still copied one by one
+__attribute__((target("sse2")))
+static void rotateRowsSSE2(const Uint32* in, Uint32* out, int w, int h,
+			   const float* ax, const float* cx,
+			   const float* by, const float* dy, Uint32 color)
+{
+  int halfw = w / 2;
+  int halfh = h / 2;
+  __m128i vhalfw = _mm_set1_epi32(halfw);
+  __m128i vhalfh = _mm_set1_epi32(halfh);
+  int xs[4] __attribute__((aligned(16)));
+  int ys[4] __attribute__((aligned(16)));
+
+  for (int r = 0; r < h; r++)
+    {
+      Uint32* row = out + r * w;
+      __m128 vby = _mm_set1_ps(by[r]);
+      __m128 vdy = _mm_set1_ps(dy[r]);
+      int c = 0;
+      for (; c + 4 <= w; c += 4)
+	{
+	  __m128i x2 = _mm_add_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(ax + c), vby)), vhalfw);
+	  __m128i y2 = _mm_sub_epi32(vhalfh, _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(cx + c), vdy)));
+	  _mm_store_si128((__m128i*)xs, x2);
+	  _mm_store_si128((__m128i*)ys, y2);
+	  for (int k = 0; k < 4; k++)
+	    {
+	      //Casting to unsigned folds the > -1 check into the < check
+	      if (unsigned(xs[k]) < unsigned(w) && unsigned(ys[k]) < unsigned(h))
+		{
+		  row[c+k] = in[(ys[k] * w) + xs[k]];
+		}
+	      else
+		{
+		  row[c+k] = color;
+		}
+	    }
+	}
+      for (; c < w; c++)
+	{
+	  int x2 = int(ax[c] + by[r]) + halfw;
+	  int y2 = halfh - int(cx[c] + dy[r]);
+	  row[c] = (unsigned(x2) < unsigned(w) && unsigned(y2) < unsigned(h)) ? in[(y2 * w) + x2] : color;
+	}
+    }
+}
+
+//AVX2 version, finds and gathers eight pixels at a time
+__attribute__((target("avx2")))
+static void rotateRowsAVX2(const Uint32* in, Uint32* out, int w, int h,
+			   const float* ax, const float* cx,
+			   const float* by, const float* dy, Uint32 color)
 {
-  //Allocate new array
-  rotation_ = new SDL_Surface*[insize];
+  int halfw = w / 2;
+  int halfh = h / 2;
+  __m256i vhalfw = _mm256_set1_epi32(halfw);
+  __m256i vhalfh = _mm256_set1_epi32(halfh);
+  __m256i vw = _mm256_set1_epi32(w);
+  __m256i vh = _mm256_set1_epi32(h);
+  __m256i none = _mm256_set1_epi32(-1);
+  __m256i vcolor = _mm256_set1_epi32(color);
 
-  //Verify they are all NULL
-  for (int i = 0; i < insize; i++)
+  for (int r = 0; r < h; r++)
     {
-      rotation_[i] = NULL;
+      Uint32* row = out + r * w;
+      __m256 vby = _mm256_set1_ps(by[r]);
+      __m256 vdy = _mm256_set1_ps(dy[r]);
+      int c = 0;
+      for (; c + 8 <= w; c += 8)
+	{
+	  __m256i x2 = _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_add_ps(_mm256_loadu_ps(ax + c), vby)), vhalfw);
+	  __m256i y2 = _mm256_sub_epi32(vhalfh, _mm256_cvttps_epi32(_mm256_add_ps(_mm256_loadu_ps(cx + c), vdy)));
+
+	  //Only gather the pixels that are in bounds, the rest keep the background color
+	  __m256i inx = _mm256_and_si256(_mm256_cmpgt_epi32(x2, none), _mm256_cmpgt_epi32(vw, x2));
+	  __m256i iny = _mm256_and_si256(_mm256_cmpgt_epi32(y2, none), _mm256_cmpgt_epi32(vh, y2));
+	  __m256i mask = _mm256_and_si256(inx, iny);
+	  __m256i source = _mm256_add_epi32(_mm256_mullo_epi32(y2, vw), x2);
+	  __m256i pixels = _mm256_mask_i32gather_epi32(vcolor, (const int*)in, source, mask, 4);
+	  _mm256_storeu_si256((__m256i*)(row + c), pixels);
+	}
+      for (; c < w; c++)
+	{
+	  int x2 = int(ax[c] + by[r]) + halfw;
+	  int y2 = halfh - int(cx[c] + dy[r]);
+	  row[c] = (unsigned(x2) < unsigned(w) && unsigned(y2) < unsigned(h)) ? in[(y2 * w) + x2] : color;
+	}
     }
+}
+#endif
 
-  //Copy surf to new location
-  rotation_[0] = SDL_CreateRGBSurface(SDL_SWSURFACE, surf->w, surf->h, surf->format->BitsPerPixel, 0, 0, 0, 0);
+//Bilinear rotation works in fixed point, with this many bits of fraction
+const int ROTATE_FRACTION_BITS = 7;
+const int ROTATE_ONE = 1 << ROTATE_FRACTION_BITS;
 
-  SDL_Rect outrect = {0, 0, Uint16(surf->w), Uint16(surf->h)};
-  SDL_FillRect(rotation_[0], &outrect, ROTATION_BACKGROUND_COLOR);
-  SDL_BlitSurface(surf, NULL, rotation_[0], NULL);
+//Added before truncating a fixed point coordinate so it is never negative,
+//which makes truncating the same as rounding down
+const float ROTATE_BIAS = 1048576.0f;
+const int ROTATE_BIAS_INT = 1048576;
 
-  //Set size and set interval
-  size_ = insize;
-  findInterval();
+//Finds the fixed point source coordinates of an output pixel
+//Every bilinear kernel computes them with exactly these float operations
+static inline int bilinearX(float a, float b, int half)
+{
+  return int((a + b) * float(ROTATE_ONE) + ROTATE_BIAS) - ROTATE_BIAS_INT + half * ROTATE_ONE;
+}
+
+static inline int bilinearY(float c, float d, int half)
+{
+  return int((c + d) * -float(ROTATE_ONE) + ROTATE_BIAS) - ROTATE_BIAS_INT + half * ROTATE_ONE;
+}
+
+//Checks whether a pixel is the background color, ignoring the unused top byte
+static inline bool isBackground(Uint32 pixel, Uint32 color)
+{
+  return ((pixel ^ color) & 0x00FFFFFF) == 0;
+}
+
+//A blended pixel that happens to land on the background color would turn
+//transparent, so nudge it off by one step of blue
+static inline Uint32 avoidBackground(Uint32 pixel, Uint32 color)
+{
+  return isBackground(pixel, color) ? (pixel ^ 1) : pixel;
+}
+
+//Blends the four source pixels around the fixed point position (fx, fy)
+//Pixels of the background color, or outside the image, get no weight, so the
+//background never bleeds into the edges. If they would make up most of the
+//blend the result is the background color instead.
+static inline Uint32 bilinearSample(const Uint32* in, int w, int h, int fx, int fy, Uint32 color)
+{
+  int x0 = fx >> ROTATE_FRACTION_BITS;
+  int y0 = fy >> ROTATE_FRACTION_BITS;
+  int ax = fx & (ROTATE_ONE - 1);
+  int ay = fy & (ROTATE_ONE - 1);
+  int weight[4] = {(ROTATE_ONE - ax) * (ROTATE_ONE - ay), ax * (ROTATE_ONE - ay),
+		   (ROTATE_ONE - ax) * ay, ax * ay};
+
+  Uint32 pixel[4];
+  int cover = 0;
+  for (int k = 0; k < 4; k++)
+    {
+      int x = x0 + (k & 1);
+      int y = y0 + (k >> 1);
+      pixel[k] = 0;
+      if (unsigned(x) < unsigned(w) && unsigned(y) < unsigned(h) &&
+	  !isBackground(in[(y * w) + x], color))
+	{
+	  pixel[k] = in[(y * w) + x];
+	  cover += weight[k];
+	}
+      else
+	{
+	  weight[k] = 0;
+	}
+    }
+  if (cover * 2 < ROTATE_ONE * ROTATE_ONE) return color;
+
+  //Weighted average of the rest, rounded to nearest
+  Uint32 out = 0;
+  for (int shift = 0; shift < 32; shift += 8)
+    {
+      int sum = 0;
+      for (int k = 0; k < 4; k++)
+	{
+	  sum += weight[k] * int((pixel[k] >> shift) & 0xFF);
+	}
+      out |= Uint32((sum + cover / 2) / cover) << shift;
+    }
+  return avoidBackground(out, color);
+}
+
+//Bilinear version of the kernels, portable version, one pixel at a time
+static void rotateRowsBilinearScalar(const Uint32* in, Uint32* out, int w, int h,
+				     const float* ax, const float* cx,
+				     const float* by, const float* dy, Uint32 color)
+{
+  int halfw = w / 2;
+  int halfh = h / 2;
+  for (int r = 0; r < h; r++)
+    {
+      Uint32* row = out + r * w;
+      for (int c = 0; c < w; c++)
+	{
+	  row[c] = bilinearSample(in, w, h, bilinearX(ax[c], by[r], halfw),
+				  bilinearY(cx[c], dy[r], halfh), color);
+	}
+    }
+}
+
+#ifdef ROTATION_X86
+//Blends four pixels that are all part of the image, SSE2 version
+//Each pair of channels is weighted and summed in one multiply-add
+//The weights add up to exactly ROTATE_ONE squared, so the average is a shift
+__attribute__((target("sse2")))
+static inline Uint32 bilinearBlendSSE2(Uint32 p00, Uint32 p10, Uint32 p01, Uint32 p11, int ax, int ay)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p00), _mm_cvtsi32_si128(p10)), zero);
+  __m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p01), _mm_cvtsi32_si128(p11)), zero);
+  int w00 = (ROTATE_ONE - ax) * (ROTATE_ONE - ay), w10 = ax * (ROTATE_ONE - ay);
+  int w01 = (ROTATE_ONE - ax) * ay, w11 = ax * ay;
+  __m128i sum = _mm_add_epi32(_mm_madd_epi16(top, _mm_set1_epi32((w10 << 16) | w00)),
+			      _mm_madd_epi16(bottom, _mm_set1_epi32((w11 << 16) | w01)));
+  sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(ROTATE_ONE * ROTATE_ONE / 2)),
+		       2 * ROTATE_FRACTION_BITS);
+  sum = _mm_packs_epi32(sum, sum);
+  sum = _mm_packus_epi16(sum, sum);
+  return Uint32(_mm_cvtsi128_si32(sum));
+}
+
+//Bilinear version of the kernels, SSE2 version
+//Finds the source coordinates four at a time, and blends the pixels inside the
+//image with SSE2. Pixels next to the edge or the background use bilinearSample.
+__attribute__((target("sse2")))
+static void rotateRowsBilinearSSE2(const Uint32* in, Uint32* out, int w, int h,
+				   const float* ax, const float* cx,
+				   const float* by, const float* dy, Uint32 color)
+{
+  int halfw = w / 2;
+  int halfh = h / 2;
+  __m128 one = _mm_set1_ps(float(ROTATE_ONE));
+  __m128 negone = _mm_set1_ps(-float(ROTATE_ONE));
+  __m128 bias = _mm_set1_ps(ROTATE_BIAS);
+  __m128i offx = _mm_set1_epi32(halfw * ROTATE_ONE - ROTATE_BIAS_INT);
+  __m128i offy = _mm_set1_epi32(halfh * ROTATE_ONE - ROTATE_BIAS_INT);
+  int xs[4] __attribute__((aligned(16)));
+  int ys[4] __attribute__((aligned(16)));
+
+  for (int r = 0; r < h; r++)
+    {
+      Uint32* row = out + r * w;
+      __m128 vby = _mm_set1_ps(by[r]);
+      __m128 vdy = _mm_set1_ps(dy[r]);
+      int c = 0;
+      for (; c + 4 <= w; c += 4)
+	{
+	  __m128 sx = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(ax + c), vby), one), bias);
+	  __m128 sy = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(cx + c), vdy), negone), bias);
+	  _mm_store_si128((__m128i*)xs, _mm_add_epi32(_mm_cvttps_epi32(sx), offx));
+	  _mm_store_si128((__m128i*)ys, _mm_add_epi32(_mm_cvttps_epi32(sy), offy));
+	  for (int k = 0; k < 4; k++)
+	    {
+	      int x0 = xs[k] >> ROTATE_FRACTION_BITS;
+	      int y0 = ys[k] >> ROTATE_FRACTION_BITS;
+	      if (unsigned(x0) < unsigned(w - 1) && unsigned(y0) < unsigned(h - 1))
+		{
+		  const Uint32* s = in + (y0 * w) + x0;
+		  if (!isBackground(s[0], color) && !isBackground(s[1], color) &&
+		      !isBackground(s[w], color) && !isBackground(s[w + 1], color))
+		    {
+		      Uint32 p = bilinearBlendSSE2(s[0], s[1], s[w], s[w + 1],
+						   xs[k] & (ROTATE_ONE - 1), ys[k] & (ROTATE_ONE - 1));
+		      row[c+k] = avoidBackground(p, color);
+		      continue;
+		    }
+		}
+	      row[c+k] = bilinearSample(in, w, h, xs[k], ys[k], color);
+	    }
+	}
+      for (; c < w; c++)
+	{
+	  row[c] = bilinearSample(in, w, h, bilinearX(ax[c], by[r], halfw),
+				  bilinearY(cx[c], dy[r], halfh), color);
+	}
+    }
+}
+#endif
+
+//Picks the fastest kernel the CPU supports
+static RotateKernel chooseRotateKernel()
+{
+#ifdef ROTATION_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return rotateRowsAVX2;
+  if (__builtin_cpu_supports("sse2")) return rotateRowsSSE2;
+#endif
+  return rotateRowsScalar;
+}
+
+static RotateKernel chooseBilinearKernel()
+{
+#ifdef ROTATION_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) return rotateRowsBilinearSSE2;
+#endif
+  return rotateRowsBilinearScalar;
+}
+
+//The kernel to use for a filter, chosen the first time an image is rotated
+static RotateKernel rotateKernel(RotationFilter filter)
+{
+  static RotateKernel nearest = chooseRotateKernel();
+  static RotateKernel bilinear = chooseBilinearKernel();
+  return (filter == ROTATION_BILINEAR) ? bilinear : nearest;
+}
+
+//Brings an angle down to the range [-PI, PI]
+static float wrapAngle(float angle)
+{
+  while (angle > 3.14159265358979323) {angle -= 3.14159265358979323 * 2;}
+  while (angle < -3.14159265358979323) {angle += 3.14159265358979323 * 2;}
+  return angle;
+}
+
+//Rotates a w by h image of 32 bit pixels by angle into out with the given kernel
+//Pixels that fall outside the original are set to color
+static void rotateWith(RotateKernel kernel, const Uint32* in, Uint32* out, int w, int h,
+		       float angle, Uint32 color)
+{
+  if (w <= 0 || h <= 0) return;
+
+  //Calculate rotation matrix
+  float rm[4];
+  rm[0] = cos(angle);
+  rm[2] = sin(angle);
+  rm[1] = -rm[2];
+  rm[3] = rm[0];
+
+  //Each output pixel at (x, y) from the center, with y flipped, reads from
+  //(rm[0]*x + rm[1]*y, rm[2]*x + rm[3]*y). Find the column and row terms once.
+  std::vector<float> ax(w), cx(w), by(h), dy(h);
+  for (int c = 0; c < w; c++)
+    {
+      int x = c - w / 2;
+      ax[c] = rm[0]*x;
+      cx[c] = rm[2]*x;
+    }
+  for (int r = 0; r < h; r++)
+    {
+      int y = -(r - h / 2);
+      by[r] = rm[1]*y;
+      dy[r] = rm[3]*y;
+    }
+
+  //Copy every pixel over, or fill with the background color if out of bounds
+  kernel(in, out, w, h, &ax[0], &cx[0], &by[0], &dy[0], color);
+}
+
+//Rotates with the fastest kernel for the filter
+static void rotatePixels(const Uint32* in, Uint32* out, int w, int h, float angle, Uint32 color,
+			 RotationFilter filter)
+{
+  rotateWith(rotateKernel(filter), in, out, w, h, angle, color);
+}
+
+//Default constructor, very bad!
+//Holds a single blank 5x5 surface
+RotationCache::RotationCache():
+  filter_(ROTATION_NEAREST),
+  map_(NULL),
+  mapSize_(0),
+  bytes_(0),
+  hits_(0),
+  misses_(0)
+{
+  SDL_Surface* blank = SDL_CreateRGBSurface(SDL_SWSURFACE, 5, 5, 32, 0, 0, 0, 0);
+  init(blank, NULL, 1);
+  SDL_FreeSurface(blank);
+}
+
+//Regular constructor
+//Takes in a pointer to a SDL_Surface and the size of the array
+RotationCache::RotationCache(SDL_Surface* surf, int insize, RotationFilter filter):
+  filter_(filter),
+  map_(NULL),
+  mapSize_(0),
+  bytes_(0),
+  hits_(0),
+  misses_(0)
+{
+  init(surf, NULL, insize);
 }
 
 //Copy constructor
-//Calls resize, so it will erase all rotations
-RotationCache::RotationCache(const RotationCache& cache)
+//Every rotation computed so far is copied over, so none are computed twice
+RotationCache::RotationCache(const RotationCache& cache):
+  filter_(cache.filter_),
+  map_(NULL),
+  mapSize_(0),
+  bytes_(0),
+  hits_(0),
+  misses_(0)
+{
+  copyFrom(cache);
+}
+
+//Move constructor
+//Takes over the pages and any background work of the other cache
+RotationCache::RotationCache(RotationCache&& cache):
+  filter_(cache.filter_),
+  map_(NULL),
+  mapSize_(0),
+  bytes_(0),
+  hits_(0),
+  misses_(0)
 {
-  size_ = 0;
-  resize(cache.size(), cache.rotation(0));
+  take(cache);
 }
 
 //Copy assignment operator
 RotationCache& RotationCache::operator=(const RotationCache& cache)
 {
-  size_ = 0;
-  resize(cache.size(), cache.rotation(0));
+  if (this == &cache) return *this;
+  clear();
+  copyFrom(cache);
   return *this;
 }
-  
+
+//Move assignment operator
+RotationCache& RotationCache::operator=(RotationCache&& cache)
+{
+  if (this == &cache) return *this;
+  clear();
+  take(cache);
+  return *this;
+}
+
 RotationCache::~RotationCache()
-{ 
+{
+  clear();
+}
+
+//Sets up empty pages for insize frames of surf's size, with surf as frame 0
+void RotationCache::init(SDL_Surface* surf, const SDL_Rect* srcrect, int insize)
+{
+  layout(srcrect ? srcrect->w : surf->w, srcrect ? srcrect->h : surf->h, insize);
+
+  //Copy surf into the first frame, on the background color
+  SDL_Surface* first = pageFor(0);
+  SDL_Rect outrect = {0, 0, Uint16(w_), Uint16(h_)};
+  SDL_FillRect(first, &outrect, ROTATION_BACKGROUND_COLOR);
+  SDL_BlitSurface(surf, const_cast<SDL_Rect*>(srcrect), first, &outrect);
+  state_[0] = SLOT_READY;
+}
+
+//Allocates the arrays for insize empty frames of the given size
+void RotationCache::layout(int w, int h, int insize)
+{
+  w_ = w;
+  h_ = h;
+  size_ = insize;
+  findInterval();
+  async_ = false;
+  precached_ = false;
+
+  //Keep each page short enough for the 16 bit rectangles SDL blits with
+  perPage_ = ROTATION_PAGE_FRAMES;
+  if (h_ > 0 && perPage_ * h_ > 32767) perPage_ = 32767 / h_;
+  if (perPage_ < 1) perPage_ = 1;
+  pages_ = (size_ + perPage_ - 1) / perPage_;
+
+  //Allocate new arrays, nothing is computed yet
+  page_ = new std::atomic<SDL_Surface*>[pages_];
+  pageUse_ = new unsigned int[pages_];
+  for (int i = 0; i < pages_; i++)
+    {
+      page_[i] = NULL;
+      pageUse_[i] = 0;
+    }
+  state_ = new std::atomic<char>[size_];
   for (int i = 0; i < size_; i++)
     {
-      if (rotation_[i] != NULL)
+      state_[i] = SLOT_EMPTY;
+    }
+}
+
+//Sets this empty cache up as a copy of another, including every finished rotation
+//Rotations still being computed by the other cache are left out
+void RotationCache::copyFrom(const RotationCache& cache)
+{
+  RotationFrame orig = cache.frameAt(0);
+  filter_ = cache.filter_;
+  init(orig.surface, &orig.rect, cache.size());
+
+  for (int i = 1; i < size_; i++)
+    {
+      if (!cache.ready(i)) continue;
+      RotationFrame from = cache.frameAt(i);
+      SDL_Surface* to = pageFor(i);
+      for (int r = 0; r < h_; r++)
 	{
-	  SDL_FreeSurface(rotation_[i]);
+	  std::memcpy((char*)to->pixels + ((i % perPage_) * h_ + r) * to->pitch,
+		      (char*)from.surface->pixels + (from.rect.y + r) * from.surface->pitch,
+		      w_ * 4);
 	}
+      state_[i] = SLOT_READY;
+    }
+}
+
+//Sets this empty cache up with everything from another, leaving that one empty
+//Background work on the other cache is stopped, then queued again for this one
+void RotationCache::take(RotationCache& cache)
+{
+  cache.cancel();
+
+  w_ = cache.w_;
+  h_ = cache.h_;
+  size_ = cache.size_;
+  interval_ = cache.interval_;
+  filter_ = cache.filter_;
+  page_ = cache.page_;
+  pages_ = cache.pages_;
+  perPage_ = cache.perPage_;
+  state_ = cache.state_;
+  async_ = false;
+  precached_ = cache.precached_;
+  map_ = cache.map_;
+  mapSize_ = cache.mapSize_;
+  pageUse_ = cache.pageUse_;
+  bytes_ = cache.bytes_.load();
+  hits_ = cache.hits_;
+  misses_ = cache.misses_;
+
+  //The other cache can only be destroyed or assigned to now
+  cache.page_ = NULL;
+  cache.pages_ = 0;
+  cache.size_ = 0;
+  cache.state_ = NULL;
+  cache.precached_ = false;
+  cache.map_ = NULL;
+  cache.mapSize_ = 0;
+  cache.pageUse_ = NULL;
+  cache.bytes_ = 0;
+
+  //Anything that was dropped from the queue is asked for again
+  if (precached_) precacheAsync();
+}
+
+//Frees every page and array, after stopping any background work
+void RotationCache::clear()
+{
+  //Workers may still be writing into the pages
+  cancel();
+
+  for (int i = 0; i < pages_; i++)
+    {
+      SDL_Surface* page = page_[i].load();
+      if (page != NULL) SDL_FreeSurface(page);
     }
-  delete[] rotation_;
+  delete[] page_;
+  delete[] pageUse_;
+  delete[] state_;
+  unmap();
+  bytes_ = 0;
 }
 
 //The main function for image rotation.
@@ -88,8 +646,7 @@ RotationCache::~RotationCache()
 SDL_Surface* RotationCache::rotateImage(SDL_Surface* inimage, float angle, Uint32 color)
 {
   //Bring down to range [-PI, PI]
-  while (angle > 3.14159265358979323) {angle -= 3.14159265358979323 * 2;}
-  while (angle < -3.14159265358979323) {angle += 3.14159265358979323 * 2;}
+  angle = wrapAngle(angle);
   
   //Check for negligible rotation
   if (angle < 0.00000001 && angle > -0.00000001) {return NULL;}
@@ -104,57 +661,9 @@ SDL_Surface* RotationCache::rotateImage(SDL_Surface* inimage, float angle, Uint3
   if (SDL_MUSTLOCK(inimage)) {SDL_LockSurface(inimage);}
   if (SDL_MUSTLOCK(outimage)) {SDL_LockSurface(outimage);}
 
-  //Extract pixels
-  Uint32* inpixels = (Uint32*)inimage->pixels;
-  Uint32* outpixels = (Uint32*)outimage->pixels;
-
-  int end = outimage->w * outimage->h;
-
-  //Calculate rotation matrix
-  float rm[4];
-  rm[0] = cos(angle);
-  rm[2] = sin(angle);
-  rm[1] = -rm[2];
-  rm[3] = rm[0];
-
-  //Cycles through all outpixels
-  for (int i = 0; i < end; i++)
-    {
-      //Find X,Y
-      int y = i / outimage->w;
-      int x = i % outimage->w;
-
-      //Adjust origin
-      y -= outimage->h / 2;
-      x -= outimage->w / 2;
-
-      //Flip over X axis
-      y *= -1;
-
-      //Multiply by RM
-      int x2 = (rm[0]*x) + (rm[1]*y);
-      int y2 = (rm[2]*x) + (rm[3]*y);
-      
-      //Move origin back and reflip
-      y2 *= -1;
-      y2 += outimage->h / 2;
-      x2 += outimage->w / 2;
-
-      //Find "i" for these coordinates
-      int source = (y2 * outimage->w) + x2;
-      
-      //Verify bounds
-      if ((x2 > -1) && (x2 < inimage->w) && (y2 > -1) && (y2 < inimage->h))
-	{
-	  //Copy over pixel
-	  outpixels[i] = inpixels[source];
-	}
-      else //Source is out of bounds
-	{
-	  //Fill with background color
-	  outpixels[i] = color;
-	}
-    }
+  //Rotate the pixels
+  rotatePixels((Uint32*)inimage->pixels, (Uint32*)outimage->pixels, outimage->w, outimage->h, angle, color,
+	       ROTATION_NEAREST);
 
   //Unlock surfaces
   if(SDL_MUSTLOCK(inimage)) {SDL_UnlockSurface(inimage);}
@@ -195,64 +704,131 @@ SDL_Surface* RotationCache::rotateImage(SDL_Surface* inimage, float angle)
 //Recaclulates the interval, erases all stored rotations, and reallocates memory
 void RotationCache::resize(int insize, SDL_Surface* surf)
 {
-  //Check for resize with no new surface
-  int i = 0;
-  SDL_Surface* oldsurf;
-  
+  //Without a new surface, keep a copy of the original since its page is going away
+  SDL_Surface* orig = surf;
   if (surf == NULL)
     {
-      oldsurf = rotation_[0];
-      i = 1;
+      RotationFrame first = frameAt(0);
+      orig = SDL_CreateRGBSurface(SDL_SWSURFACE, w_, h_, 32, 0, 0, 0, 0);
+      SDL_Rect outrect = {0, 0, Uint16(w_), Uint16(h_)};
+      SDL_FillRect(orig, &outrect, ROTATION_BACKGROUND_COLOR);
+      SDL_BlitSurface(first.surface, &first.rect, orig, NULL);
     }
-  
-  //Erase the current rotations
-  while (i < size_)
+
+  clear();
+  init(orig, NULL, insize);
+
+  if (surf == NULL) SDL_FreeSurface(orig);
+}
+
+//Returns the computed frame closest to the given angle
+//If the exact rotation does not exist yet, it is queued to be computed in the
+//background and a nearby one is returned in the meantime
+RotationFrame RotationCache::rotation(float angle)
+{
+  int index = nearestIndex(angle);
+
+  //Most of the time it's already there
+  if (ready(index))
     {
-      if (rotation_[i] != NULL)
-	{
-	  SDL_FreeSurface(rotation_[i]);
-	}
-      i++;
+      hits_++;
     }
-
-  if (size_ > 1)
+  else
     {
-      delete[] rotation_;
+      //Otherwise, have it computed and make do for now
+      misses_++;
+      request(index);
+      index = nearestReady(index);
     }
 
-  //Allocate new array
-  rotation_ = new SDL_Surface*[insize];
+  pageUse_[index / perPage_] = frame_;
+  return frameAt(index);
+}
+
+//Returns the computed frame closest to the given angle
+//The const version will always find the closest, never creating a new rotation
+RotationFrame RotationCache::rotation(float angle) const
+{
+  return frameAt(nearestReady(nearestIndex(angle)));
+}
+
+//Checks whether the rotation at an index has been computed
+bool RotationCache::ready(int index) const
+{
+  return state_[index].load(std::memory_order_acquire) == SLOT_READY;
+}
+
+//Draws the rotation nearest to angle with its top left corner at dest
+RotationFrame RotationCache::blit(float angle, SDL_Surface* screen, SDL_Rect* dest)
+{
+  RotationFrame f = rotation(angle);
+  SDL_BlitSurface(f.surface, &f.rect, screen, dest);
+  return f;
+}
+
+//Computes a queued rotation and stores it in its page
+//A slot that is no longer queued was cancelled, and is left alone
+void RotationCache::compute(int index)
+{
+  char expected = SLOT_QUEUED;
+  if (!state_[index].compare_exchange_strong(expected, SLOT_CLAIMED)) return;
+
+  //Compute the required angle
+  float angle = float(index) * interval_;
+
+  //Rotate straight into the page
+  SDL_Surface* page = pageFor(index);
+  Uint32* out = (Uint32*)((char*)page->pixels + (index % perPage_) * h_ * page->pitch);
+  rotateInto(angle, out);
+
+  //Publish it
+  state_[index].store(SLOT_READY, std::memory_order_release);
+}
 
-  //Verify they are all NULL
-  for (i = 0; i < insize; i++)
+//Queues "count" rotations, skipping over rotations which are already computed or queued
+//Will return false if anything is left to be queued afterwards
+//Returns true if the structure is now full or on its way (or was full to begin with)
+bool RotationCache::precache(int count)
+{
+  int i;
+
+  //Go until count is empty or the end is reached
+  for (i = 0; i < size_ && count > 0; i++)
     {
-      rotation_[i] = NULL;
+      //If this one's not done or queued yet
+      if (state_[i].load(std::memory_order_acquire) == SLOT_EMPTY)
+	{
+	  request(i);
+	  count--;
+	}
     }
 
-  //Copy the inputted surface or re-insert the old one
-  if (surf == NULL)
+  //Anything left past where we stopped still needs queueing
+  for (; i < size_; i++)
     {
-      rotation_[0] = oldsurf;
+      if (state_[i].load(std::memory_order_acquire) == SLOT_EMPTY) return false;
     }
-  else
+  return true;
+}
+
+//Queues every missing rotation to be computed in the background
+void RotationCache::precacheAsync()
+{
+  precached_ = true;
+  for (int i = 0; i < size_; i++)
     {
-      rotation_[0] = SDL_CreateRGBSurface(SDL_SWSURFACE, surf->w, surf->h, surf->format->BitsPerPixel, 0, 0, 0, 0);
-      SDL_Rect outrect = {0, 0, Uint16(surf->w), Uint16(surf->h)};
-      SDL_FillRect(rotation_[0], &outrect, ROTATION_BACKGROUND_COLOR);
-      SDL_BlitSurface(surf, NULL, rotation_[0], NULL);
-      SDL_SetColorKey(rotation_[0], SDL_SRCCOLORKEY, SDL_MapRGB( rotation_[0]->format, 160, 150, 0 ) );
+      request(i);
     }
+}
 
-  //Set new size and set interval
-  size_ = insize;
-  findInterval();
+//Calculates the interval from size_ and stores it in interval_
+void RotationCache::findInterval()
+{
+  interval_ = (2 * rotatePi) / (float)size_;
 }
 
-//Returns a pointer to the SDL_Surface closest to the given angle
-//If it does not exist, it is created immediately
-//For small images, this isn't bad, as the workload will never be too large
-//For larger images, try to find time to precache
-SDL_Surface* RotationCache::rotation(float angle)
+//Finds the index closest to the given angle
+int RotationCache::nearestIndex(float angle) const
 {
   //Bring down to proper range
   while (angle > (2 * 3.14159265358979323)) {angle -= 3.14159265358979323 * 2;}
@@ -270,126 +846,307 @@ SDL_Surface* RotationCache::rotation(float angle)
       index = size_ - 0.9;
     }
 
-  //If that rotation does not exist, calculate it
-  if (rotation_[(int)index] == NULL)
+  //A full turn rounds up to size_, which is the same as 0
+  if (int(index) >= size_) return 0;
+  return int(index);
+}
+
+//Finds the index of the computed rotation nearest to the given index
+//Rotations wrap around, and frame 0 is always ready
+int RotationCache::nearestReady(int index) const
+{
+  for (int d = 0; d <= size_ / 2; d++)
     {
-      compute((int)index);
+      int up = (index + d) % size_;
+      int down = (index - d + size_) % size_;
+      if (ready(up)) return up;
+      if (ready(down)) return down;
     }
-
-  //Return it
-  return rotation_[(int)index];
+  return 0;
 }
 
-//Returns a pointer to the SDL_Surface closest to the given angle
-//The const version will always find the closest, never creating a new rotation
-//For small images, this isn't bad, as the workload will never be too large
-//For larger images, try to find time to precache
-SDL_Surface* RotationCache::rotation(float angle) const
-{//Bring down to proper range
-  while (angle > (2 * 3.14159265358979323)) {angle -= 3.14159265358979323 * 2;}
-  while (angle < 0) {angle += 3.14159265358979323 * 2;}
-  
-  //Caclulate closest index
-  float index = angle/interval_;
+//Locates a frame within its page, which must exist
+RotationFrame RotationCache::frameAt(int index) const
+{
+  RotationFrame f;
+  f.surface = page_[index / perPage_].load(std::memory_order_acquire);
+  f.rect.x = 0;
+  f.rect.y = Sint16((index % perPage_) * h_);
+  f.rect.w = Uint16(w_);
+  f.rect.h = Uint16(h_);
+  return f;
+}
 
-  //Round to nearest index
-  index = int(index + .5) + .01;
+//Gets the page for a frame, creating it if this is the first frame there
+//Two workers may race to create a page, the loser throws its copy away
+SDL_Surface* RotationCache::pageFor(int index)
+{
+  int p = index / perPage_;
+  SDL_Surface* page = page_[p].load(std::memory_order_acquire);
+  if (page != NULL) return page;
 
-  //Ensure that we haven't gone too far
-  if (index > size_)
+  SDL_Surface* fresh = SDL_CreateRGBSurface(SDL_SWSURFACE, w_, h_ * framesIn(p), 32, 0, 0, 0, 0);
+  SDL_SetColorKey(fresh, SDL_SRCCOLORKEY, SDL_MapRGB(fresh->format, 160, 150, 0));
+  if (page_[p].compare_exchange_strong(page, fresh))
     {
-      index = size_ - 0.9;
+      bytes_ += long(fresh->pitch) * fresh->h;
+      return fresh;
     }
+  SDL_FreeSurface(fresh);
+  return page;
+}
 
-  //Expand outward until a suitable rotation is found
-  for (int i = (int)index, j = (int)index; i > -1; i++, j++)
+//Number of frames held by a page, only the last one may be short
+int RotationCache::framesIn(int page) const
+{
+  int left = size_ - page * perPage_;
+  return (left < perPage_) ? left : perPage_;
+}
+
+//Rotates the original by angle into out, which holds w_*h_ pixels
+//The original is the first frame of the first page, which is never evicted
+void RotationCache::rotateInto(float angle, Uint32* out) const
+{
+  SDL_Surface* first = page_[0].load(std::memory_order_acquire);
+  Uint32 color = SDL_MapRGB(first->format, 160, 150, 0);
+  rotatePixels((const Uint32*)first->pixels, out, w_, h_, wrapAngle(angle), color, filter_);
+}
+
+//Queues a rotation to be computed in the background, if it isn't already
+void RotationCache::request(int index)
+{
+  char expected = SLOT_EMPTY;
+  if (!state_[index].compare_exchange_strong(expected, SLOT_QUEUED)) return;
+  async_ = true;
+  ThreadPool::shared().submit(computeJob, this, index);
+}
+
+//Job run by the thread pool, computes one rotation of a cache
+void RotationCache::computeJob(void* cache, int index)
+{
+  ((RotationCache*)cache)->compute(index);
+}
+
+//Stops any background work on this cache
+//Queued slots are set back to empty so they can be requested again
+void RotationCache::cancel()
+{
+  if (!async_) return;
+  ThreadPool::shared().cancel(this);
+  for (int i = 0; i < size_; i++)
     {
-      if (rotation_[i] != NULL)
-	{
-	  return rotation_[i];
-	}
-      else if (j < size_)
-	{
-	  if (rotation_[j] != NULL)
-	    {
-	      return rotation_[j];
-	    }
-	}
+      if (state_[i] == SLOT_QUEUED) state_[i] = SLOT_EMPTY;
     }
-  
-  //If somehow we got past that last step, return rotation_[0]
-  return rotation_[0];
+  async_ = false;
 }
 
-//Computes the rotation using rotateImage and stores it in the cache
-void RotationCache::compute(int index)
+//Frees a page so its rotations will be computed again if they are needed
+//Returns the number of bytes freed
+long RotationCache::evictPage(int page)
 {
-  //Ensure nothing gets double-caclulated
-  if (rotation_[index] != NULL)
+  //The first page holds the original, and mapped pages belong to the file
+  if (page <= 0 || page >= pages_ || map_ != NULL) return 0;
+
+  SDL_Surface* surf = page_[page].load(std::memory_order_acquire);
+  if (surf == NULL) return 0;
+
+  //Workers only write into slots they claim from queued, and every rotation is
+  //queued by request() on this thread, so a page with none queued or claimed
+  //can't be written to while it is freed
+  int first = page * perPage_;
+  int last = first + framesIn(page);
+  for (int i = first; i < last; i++)
     {
-      return;
+      char s = state_[i].load(std::memory_order_acquire);
+      if (s == SLOT_QUEUED || s == SLOT_CLAIMED) return 0;
+    }
+  for (int i = first; i < last; i++)
+    {
+      state_[i].store(SLOT_EMPTY, std::memory_order_release);
     }
-  
-  //Compute the required angle
-  float angle = float(index) * interval_;
 
-  //Rotate!
-  rotation_[index] = rotateImage(rotation_[0], angle);
-  SDL_SetColorKey(rotation_[index], SDL_SRCCOLORKEY, SDL_MapRGB( rotation_[index]->format, 160, 150, 0 ) );
+  page_[page].store(NULL, std::memory_order_release);
+  long freed = long(surf->pitch) * surf->h;
+  bytes_ -= freed;
+  SDL_FreeSurface(surf);
+  return freed;
 }
 
-void RotationCache::compute(float angle)
+//Returns the memory use and lookup counts for this cache
+RotationStats RotationCache::stats() const
 {
-  //Bring down to proper range
-  while (angle > (2 * 3.14159265358979323)) {angle -= 3.14159265358979323 * 2;}
-  while (angle < 0) {angle += 3.14159265358979323 * 2;}
-  
-  //Caclulate closest index
-  float index = angle/interval_;
-
-  //Round to nearest index
-  index = int(index + .5) + .01;
+  RotationStats s = {bytes_.load(), hits_, misses_, 0};
+  return s;
+}
 
-  //Ensure that we haven't gone too far
-  if (index > size_)
+//Checks whether every rotation has been queued and the workers are done with them
+bool RotationCache::settled() const
+{
+  if (!precached_) return false;
+  for (int i = 0; i < size_; i++)
     {
-      index = size_ - 0.9;
+      char s = state_[i].load(std::memory_order_acquire);
+      if (s == SLOT_QUEUED || s == SLOT_CLAIMED) return false;
     }
-
-  compute((int)index);
+  return true;
 }
 
-//Computes "count" rotations, skipping over rotations which are already calculated
-//Will return false if anything is left to be calculated afterwards
-//Returns true if the structure is now full (or was full to begin with)
-bool RotationCache::precache(int count)
+//Replaces the whole cache with the frames in an atlas file
+//The file is mapped, so the frames are only read from disk as they are drawn
+bool RotationCache::loadAtlas(const std::string& path, int insize, RotationFilter filter)
 {
-  int i;
-  
-  //Go until count is empty or the end is reached
-  for (i = 0; i < size_ && count > 0; i++)
+  //Get the file into memory
+  void* map = NULL;
+  size_t mapSize = 0;
+#ifdef ROTATION_MMAP
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(AtlasHeader))
     {
-      //If this one's not done yet
-      if (rotation_[i] == NULL)
+      mapSize = st.st_size;
+      //Private and writable, so SDL may lock the surfaces without touching the file
+      map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) map = NULL;
+    }
+  close(fd);
+#else
+  FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == NULL) return false;
+  std::fseek(file, 0, SEEK_END);
+  long length = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  if (length >= long(sizeof(AtlasHeader)))
+    {
+      mapSize = length;
+      map = new char[mapSize];
+      if (std::fread(map, 1, mapSize, file) != mapSize)
 	{
-	  //Compute it
-	  compute(i);
-	  count--;
+	  delete[] (char*)map;
+	  map = NULL;
 	}
     }
+  std::fclose(file);
+#endif
+  if (map == NULL) return false;
+
+  //Make sure it's what we're expecting
+  //The frames are packed, so they can be used as pages just as they are
+  AtlasHeader header;
+  std::memcpy(&header, map, sizeof(header));
+  size_t frameSize = size_t(header.pitch) * header.h;
+  if (std::memcmp(header.magic, "GROT", 4) != 0 ||
+      header.version != ROTATION_ATLAS_VERSION ||
+      int(header.count) != insize || header.filter != Uint32(filter) ||
+      header.pitch != header.w * 4 ||
+      mapSize != sizeof(AtlasHeader) + frameSize * insize)
+    {
+#ifdef ROTATION_MMAP
+      munmap(map, mapSize);
+#else
+      delete[] (char*)map;
+#endif
+      return false;
+    }
 
-  //Return the proper result
-  if (i == size_ - 1)
+  //Throw out everything there is now
+  clear();
+  map_ = map;
+  mapSize_ = mapSize;
+  filter_ = filter;
+  layout(header.w, header.h, insize);
+
+  //Every page points into the file
+  char* pixels = (char*)map + sizeof(AtlasHeader);
+  for (int p = 0; p < pages_; p++)
     {
-      return true;
+      SDL_Surface* page = SDL_CreateRGBSurfaceFrom(pixels + frameSize * p * perPage_, w_, h_ * framesIn(p),
+						   32, header.pitch, 0, 0, 0, 0);
+      SDL_SetColorKey(page, SDL_SRCCOLORKEY, SDL_MapRGB(page->format, 160, 150, 0));
+      page_[p] = page;
     }
-  return false;
+  for (int i = 0; i < size_; i++)
+    {
+      state_[i] = SLOT_READY;
+    }
+  precached_ = true;
+  return true;
 }
 
-//Calculates the interval from size_ and stores it in interval_
-void RotationCache::findInterval()
+//An atlas waiting to be written by the thread pool, with its own copy of the frames
+struct AtlasWrite
 {
-  interval_ = (2 * rotatePi) / (float)size_;
+  std::string path;
+  AtlasHeader header;
+  std::vector<char> pixels;
+};
+
+//Job run by the thread pool, writes out an atlas and then frees it
+//The file is written under a temporary name first, so a partial one is never loaded
+static void writeAtlasJob(void* atlas, int)
+{
+  AtlasWrite* a = (AtlasWrite*)atlas;
+  std::string temp = a->path + ".tmp";
+  FILE* file = std::fopen(temp.c_str(), "wb");
+  if (file != NULL)
+    {
+      bool ok = std::fwrite(&a->header, sizeof(a->header), 1, file) == 1 &&
+	std::fwrite(&a->pixels[0], a->pixels.size(), 1, file) == 1;
+      if (std::fclose(file) != 0) ok = false;
+      if (!ok || std::rename(temp.c_str(), a->path.c_str()) != 0) std::remove(temp.c_str());
+    }
+  delete a;
+}
+
+//Copies every frame and has the thread pool write them out to an atlas file
+//Returns false without doing anything if any frame is missing, as after eviction
+bool RotationCache::saveAtlas(const std::string& path)
+{
+  for (int i = 0; i < size_; i++)
+    {
+      if (!ready(i)) return false;
+    }
+
+  AtlasWrite* a = new AtlasWrite;
+  a->path = path;
+  std::memset(&a->header, 0, sizeof(a->header));
+  std::memcpy(a->header.magic, "GROT", 4);
+  a->header.version = ROTATION_ATLAS_VERSION;
+  a->header.w = w_;
+  a->header.h = h_;
+  a->header.pitch = w_ * 4;
+  a->header.count = size_;
+  a->header.filter = filter_;
+
+  //The pages may be evicted as soon as this returns, so the job gets a copy
+  a->pixels.resize(size_t(a->header.pitch) * h_ * size_);
+  char* out = &a->pixels[0];
+  for (int i = 0; i < size_; i++)
+    {
+      RotationFrame f = frameAt(i);
+      for (int r = 0; r < h_; r++)
+	{
+	  std::memcpy(out, (char*)f.surface->pixels + (f.rect.y + r) * f.surface->pitch, a->header.pitch);
+	  out += a->header.pitch;
+	}
+    }
+
+  ThreadPool::shared().submit(writeAtlasJob, a, 0);
+  return true;
+}
+
+//Releases the atlas file the pages were loaded from, if any
+//The pages pointing into it must already be freed
+void RotationCache::unmap()
+{
+  if (map_ == NULL) return;
+#ifdef ROTATION_MMAP
+  munmap(map_, mapSize_);
+#else
+  delete[] (char*)map_;
+#endif
+  map_ = NULL;
+  mapSize_ = 0;
 }
 
 #endif
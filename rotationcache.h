@@ -8,17 +8,73 @@
 
   Works with rotateImage to store rotations of a given
   SDL_Surface, caching them in case the same rotation is called later.
-  This is the non-threaded version, fully compatible with C++03
+
+  The rotations are packed into pages, each one surface holding a column of
+  up to ROTATION_PAGE_FRAMES frames. Frames are drawn by blitting their
+  rectangle out of the page, so a cache is a handful of allocations instead
+  of one per rotation.
+
+  Missing rotations can be computed in the background on the shared
+  ThreadPool. Each slot has an atomic state, and a worker publishes a finished
+  frame by marking its slot ready, so readers never take a lock.
+
+  Each page also remembers the frame it was last shown in, so that the
+  RotationRegistry can evict the least recently used pages when all caches
+  together go over their memory budget.
+
+  Rotations can be sampled nearest neighbor, or blended bilinearly. The
+  bilinear filter leaves the background color out of the blend so edges stay
+  clean, and looks smooth with far fewer rotations stored.
+
+  A finished cache can be saved as an atlas file, every frame one after the
+  other, and later mapped straight back into memory. Mapped frames belong to
+  the file, so they are not counted against the budget or evicted.
 */
 #ifndef _rotationcache_h_
 #define _rotationcache_h_
 
 #include "SDL/SDL.h"
+#include <atomic>
+#include <string>
 
 const float rotatePi = 3.14159265358979323;
 
 const unsigned int ROTATION_BACKGROUND_COLOR = 0xA09600;
 
+//Change whenever rotateImage changes, so old atlas files are not loaded
+const unsigned int ROTATION_ATLAS_VERSION = 2;
+
+//How each rotated pixel is found from the original
+enum RotationFilter
+{
+  ROTATION_NEAREST,  //Copies the closest pixel
+  ROTATION_BILINEAR  //Blends the four closest pixels, ignoring the background
+};
+
+//The most frames packed into one page
+const int ROTATION_PAGE_FRAMES = 25;
+
+//Counters for sizing the rotation memory budget
+struct RotationStats
+{
+  //Bytes of pixel data currently held
+  long bytes;
+
+  //Rotations asked for that were already computed, or that had to be queued
+  long hits;
+  long misses;
+
+  //Pages freed to stay within the budget
+  long evictions;
+};
+
+//Where to find one rotation, the part of surface inside rect
+struct RotationFrame
+{
+  SDL_Surface* surface;
+  SDL_Rect rect;
+};
+
 class RotationCache
 {
  public:
@@ -27,15 +83,21 @@ class RotationCache
   RotationCache();
 
   //Regular constructor
-  //Takes in a pointer to a SDL_Surface and a size for precision
+  //Takes in a pointer to a SDL_Surface, a size for precision, and the filter to rotate with
   //The original SDL_Surface will be copied over, and can be deleted by the user
-  RotationCache(SDL_Surface* surf, int insize);
+  RotationCache(SDL_Surface* surf, int insize, RotationFilter filter = ROTATION_NEAREST);
 
   //Copy constructor
+  //Copies keep every rotation already computed
   RotationCache(const RotationCache& cache);
 
-  //Assignment operator
+  //Move constructor
+  //The moved-from cache may only be destroyed or assigned to
+  RotationCache(RotationCache&& cache);
+
+  //Assignment operators
   RotationCache& operator=(const RotationCache& cache);
+  RotationCache& operator=(RotationCache&& cache);
 
   //Destructor
   ~RotationCache();
@@ -49,31 +111,149 @@ class RotationCache
   void resize(int insize, SDL_Surface* surf = NULL);
 
   //Accessors
-  SDL_Surface* rotation(float angle);
-  SDL_Surface* rotation(float angle) const;
+  //Both return the nearest rotation already computed, so they never stall
+  //The non-const version also queues the exact rotation to be computed
+  RotationFrame rotation(float angle);
+  RotationFrame rotation(float angle) const;
+  bool ready(int index) const;
   int size() {return size_;}
   int size() const {return size_;}
+  int width() const {return w_;}
+  int height() const {return h_;}
+  RotationFilter filter() const {return filter_;}
 
-  //Computes and stores the rotation for a given index (int) or angle (float)
-  void compute(int index);
-  void compute(float angle);
+  //Draws the rotation nearest to angle with its top left corner at dest
+  //Returns the frame that was drawn
+  RotationFrame blit(float angle, SDL_Surface* screen, SDL_Rect* dest);
 
-  //Computes and stores the given number of rotations
-  //Meant to be called bit by bit in times of low computational requirements
+  //Queues up to count missing rotations to be computed in the background
+  //Returns true if every rotation is now computed or queued
+  //Only call this from the thread that draws, as pages may be evicted there
   bool precache(int count);
 
+  //Queues every missing rotation to be computed in the background
+  void precacheAsync();
+
+  //Memory management
+  //Only call these from the thread that draws, between frames
+  //evictPage frees a page other than the first, which holds the original,
+  //and returns the bytes freed. Pages with rotations in progress are skipped.
+  int pages() const {return pages_;}
+  long evictPage(int page);
+  unsigned int pageUse(int page) const {return pageUse_[page];}
+  RotationStats stats() const;
+
+  //Atlas files
+  //loadAtlas replaces the whole cache with the frames in the file, and fails without
+  //changing anything if the file is missing or doesn't hold insize frames made with filter
+  //saveAtlas copies every frame and writes them out on the thread pool, or returns false
+  //without doing anything if any are missing
+  bool loadAtlas(const std::string& path, int insize, RotationFilter filter = ROTATION_NEAREST);
+  bool saveAtlas(const std::string& path);
+  bool mapped() const {return map_ != NULL;}
+
+  //Checks whether every rotation has been queued and the workers are done with them
+  bool settled() const;
+
+  //Advances the frame counter used to stamp each rotation as it is shown
+  static void nextFrame() {frame_++;}
+  static unsigned int frame() {return frame_;}
+
  private:
+  //Sets up empty pages for insize frames of surf's size, with surf as frame 0
+  //Only the part of surf inside srcrect is used, if given
+  void init(SDL_Surface* surf, const SDL_Rect* srcrect, int insize);
+
+  //Allocates the arrays for insize empty frames of the given size
+  void layout(int w, int h, int insize);
+
+  //Fills in this empty cache from another one
+  void copyFrom(const RotationCache& cache);
+  void take(RotationCache& cache);
+
+  //Frees every page and array, after stopping any background work
+  void clear();
+
   //Helper function to compute the interval using the stored size
   void findInterval();
-  
-  //Pointer to the array of pointers to SDL_Surfaces
-  SDL_Surface** rotation_;
 
-  //Size of the array
+  //Finds the index closest to the given angle
+  int nearestIndex(float angle) const;
+
+  //Finds the index of the computed rotation nearest to the given index
+  int nearestReady(int index) const;
+
+  //Locates a frame within its page, which must exist
+  RotationFrame frameAt(int index) const;
+
+  //Gets the page for a frame, creating it if this is the first frame there
+  //Safe to call from any thread
+  SDL_Surface* pageFor(int index);
+
+  //Number of frames held by a page
+  int framesIn(int page) const;
+
+  //Rotates the original by angle into out, which holds w_*h_ pixels
+  void rotateInto(float angle, Uint32* out) const;
+
+  //Queues a rotation to be computed in the background, if it isn't already
+  //Every rotation is computed this way, so eviction knows what is in progress
+  void request(int index);
+
+  //Computes and stores a queued rotation, run by the thread pool
+  void compute(int index);
+  static void computeJob(void* cache, int index);
+
+  //Stops any background work on this cache
+  void cancel();
+
+  //Releases the atlas file the frames were loaded from, if any
+  void unmap();
+
+  //Size of every frame
+  int w_, h_;
+
+  //Number of rotations
   int size_;
 
   //Rotation interval, in radians, between stored images
   float interval_;
+
+  //How the rotations are sampled
+  RotationFilter filter_;
+
+  //The pages, NULL until a frame in them is computed
+  //Frame i is number i % perPage_ in page i / perPage_
+  std::atomic<SDL_Surface*>* page_;
+  int pages_;
+  int perPage_;
+
+  //The state of each slot, one of the SLOT_ constants
+  //A frame may only be read once its slot is ready
+  std::atomic<char>* state_;
+
+  //Whether any rotations have been handed to the thread pool
+  bool async_;
+
+  //Whether every rotation has been asked for with precacheAsync
+  bool precached_;
+
+  //The atlas file the pages point into, or NULL if they were computed
+  void* map_;
+  size_t mapSize_;
+
+  //The frame each page was last shown in
+  unsigned int* pageUse_;
+
+  //Bytes held, updated by workers as they create pages
+  std::atomic<long> bytes_;
+
+  //Lookups that found the exact rotation ready, or had to queue it
+  long hits_;
+  long misses_;
+
+  //The current frame, shared by every cache
+  static unsigned int frame_;
 };
 
 #endif
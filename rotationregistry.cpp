@@ -0,0 +1,288 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Rotation Registry Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the RotationRegistry and SharedRotation classes.
+*/
+
+#ifndef _rotationregistry_cpp_
+#define _rotationregistry_cpp_
+
+#include "rotationregistry.h"
+#include "scale.h"
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+//A page of rotations that could be evicted, ordered by when it was last shown
+struct EvictCandidate
+{
+  unsigned int lastUse;
+  RotationCache* cache;
+  int page;
+
+  bool operator<(const EvictCandidate& e) const {return lastUse < e.lastUse;}
+};
+
+//Constructor, starts with the default budget
+RotationRegistry::RotationRegistry():
+  budget_(ROTATION_CACHE_BUDGET),
+  evictions_(0),
+  pastHits_(0),
+  pastMisses_(0)
+{}
+
+//Orders keys by every field, for the map
+bool RotationRegistry::Key::operator<(const Key& k) const
+{
+  if (source != k.source) return source < k.source;
+  if (w != k.w) return w < k.w;
+  if (h != k.h) return h < k.h;
+  if (count != k.count) return count < k.count;
+  return filter < k.filter;
+}
+
+//Finds the cache for source scaled by scale with count rotations, making it if needed
+RotationCache* RotationRegistry::acquire(SDL_Surface* source, float scale, int count,
+					 RotationFilter filter)
+{
+  if (source == NULL) return NULL;
+
+  //Planets of slightly different sizes often scale to the same pixel size,
+  //so the key uses the size scaleNN would produce rather than the ratio
+  Key key = {source, int(source->w*scale), int(source->h*scale), count, filter};
+  std::map<Key, Entry>::iterator found = entries_.find(key);
+  if (found != entries_.end())
+    {
+      found->second.refs++;
+      return found->second.cache;
+    }
+
+  //See if an earlier run left the rotations on disk
+  Entry entry = {NULL, 1, "", false};
+  if (!atlasDir_.empty())
+    {
+      entry.atlas = atlasPath(key);
+      RotationCache* loaded = new RotationCache();
+      if (loaded->loadAtlas(entry.atlas, count, filter))
+	{
+	  entry.cache = loaded;
+	  entries_[key] = entry;
+	  keys_[loaded] = key;
+	  return loaded;
+	}
+      delete loaded;
+      entry.unsaved = true;
+
+      //Make sure there's somewhere to save it once it's finished
+#if defined(__unix__) || defined(__APPLE__)
+      mkdir(atlasDir_.c_str(), 0755);
+#endif
+    }
+
+  //Not cached yet, so scale the source and make the rotations
+  //RotationCache copies the surface it is given
+  RotationCache* cache;
+  if (key.w == source->w && key.h == source->h)
+    {
+      cache = new RotationCache(source, count, filter);
+    }
+  else
+    {
+      SDL_Surface* scaled = scaleNN(source, scale);
+      if (scaled == NULL) return NULL;
+      cache = new RotationCache(scaled, count, filter);
+      SDL_FreeSurface(scaled);
+    }
+
+  entry.cache = cache;
+  entries_[key] = entry;
+  keys_[cache] = key;
+  return cache;
+}
+
+//Adds a reference to a cache from acquire
+void RotationRegistry::retain(RotationCache* cache)
+{
+  std::map<RotationCache*, Key>::iterator k = keys_.find(cache);
+  if (k == keys_.end()) return;
+  entries_[k->second].refs++;
+}
+
+//Drops a reference to a cache from acquire, freeing it with the last one
+void RotationRegistry::release(RotationCache* cache)
+{
+  std::map<RotationCache*, Key>::iterator k = keys_.find(cache);
+  if (k == keys_.end()) return;
+  std::map<Key, Entry>::iterator e = entries_.find(k->second);
+  if (--(e->second.refs) > 0) return;
+
+  //Nobody is using it, the destructor stops any background work
+  RotationStats s = cache->stats();
+  pastHits_ += s.hits;
+  pastMisses_ += s.misses;
+  delete cache;
+  entries_.erase(e);
+  keys_.erase(k);
+}
+
+//Returns the total number of references held to all caches
+int RotationRegistry::references() const
+{
+  int total = 0;
+  for (std::map<Key, Entry>::const_iterator i = entries_.begin(); i != entries_.end(); i++)
+    {
+      total += i->second.refs;
+    }
+  return total;
+}
+
+//Per-frame upkeep, saves finished caches and then enforces the budget
+void RotationRegistry::update()
+{
+  saveAtlases();
+  enforceBudget();
+}
+
+//Starts writing out every cache that is finished and not yet on disk
+//Only one is copied per call, to spread the work over several frames
+//Caches missing evicted rotations are tried again once those are back
+void RotationRegistry::saveAtlases()
+{
+  for (std::map<Key, Entry>::iterator i = entries_.begin(); i != entries_.end(); i++)
+    {
+      Entry& e = i->second;
+      if (!e.unsaved || !e.cache->settled()) continue;
+      if (!e.cache->saveAtlas(e.atlas)) continue;
+
+      //Whether or not the write works, don't try again
+      e.unsaved = false;
+      return;
+    }
+}
+
+//Finds the atlas file name for a key, from the source pixels
+//The source is hashed with 64-bit FNV-1a, row by row to skip any padding
+std::string RotationRegistry::atlasPath(const Key& key) const
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  SDL_Surface* s = key.source;
+  if (SDL_MUSTLOCK(s)) SDL_LockSurface(s);
+  for (int r = 0; r < s->h; r++)
+    {
+      const unsigned char* row = (const unsigned char*)s->pixels + r * s->pitch;
+      for (int b = 0; b < s->w * s->format->BytesPerPixel; b++)
+	{
+	  hash = (hash ^ row[b]) * 1099511628211ULL;
+	}
+    }
+  if (SDL_MUSTLOCK(s)) SDL_UnlockSurface(s);
+
+  char name[96];
+  std::snprintf(name, sizeof(name), "/rot-%016llx-%dx%d-%d%s.atlas", hash, key.w, key.h, key.count,
+		key.filter == ROTATION_BILINEAR ? "-bl" : "");
+  return atlasDir_ + name;
+}
+
+//Evicts the least recently shown pages until all caches fit in the budget
+void RotationRegistry::enforceBudget()
+{
+  //Anything shown from here on is newer than everything shown before
+  RotationCache::nextFrame();
+  if (budget_ <= 0) return;
+
+  long bytes = stats().bytes;
+  if (bytes <= budget_) return;
+
+  //Gather every page that can go, oldest first
+  std::vector<EvictCandidate> candidates;
+  for (std::map<Key, Entry>::iterator i = entries_.begin(); i != entries_.end(); i++)
+    {
+      RotationCache* cache = i->second.cache;
+      if (cache->mapped()) continue;
+      for (int j = 1; j < cache->pages(); j++)
+	{
+	  EvictCandidate e = {cache->pageUse(j), cache, j};
+	  candidates.push_back(e);
+	}
+    }
+  std::sort(candidates.begin(), candidates.end());
+
+  //Free them until we fit
+  for (unsigned int i = 0; i < candidates.size() && bytes > budget_; i++)
+    {
+      long freed = candidates[i].cache->evictPage(candidates[i].page);
+      if (freed == 0) continue;
+      bytes -= freed;
+      evictions_++;
+    }
+}
+
+//Returns the memory use and lookup counts of all caches together
+RotationStats RotationRegistry::stats() const
+{
+  RotationStats total = {0, pastHits_, pastMisses_, evictions_};
+  for (std::map<Key, Entry>::const_iterator i = entries_.begin(); i != entries_.end(); i++)
+    {
+      RotationStats s = i->second.cache->stats();
+      total.bytes += s.bytes;
+      total.hits += s.hits;
+      total.misses += s.misses;
+    }
+  return total;
+}
+
+//Returns the registry shared by the whole game
+RotationRegistry& RotationRegistry::shared()
+{
+  static RotationRegistry registry;
+  return registry;
+}
+
+//Acquires the shared cache for source scaled by scale with count rotations
+SharedRotation::SharedRotation(SDL_Surface* source, float scale, int count, RotationFilter filter):
+  cache_(RotationRegistry::shared().acquire(source, scale, count, filter))
+{}
+
+//Copy constructor, shares the cache
+SharedRotation::SharedRotation(const SharedRotation& other):
+  cache_(other.cache_)
+{
+  if (cache_ != NULL) RotationRegistry::shared().retain(cache_);
+}
+
+//Assignment operator, shares the cache and lets go of the old one
+SharedRotation& SharedRotation::operator=(const SharedRotation& other)
+{
+  //Retain first, in case both refer to the same cache
+  if (other.cache_ != NULL) RotationRegistry::shared().retain(other.cache_);
+  if (cache_ != NULL) RotationRegistry::shared().release(cache_);
+  cache_ = other.cache_;
+  return *this;
+}
+
+//Move assignment operator, takes over the reference without touching the count
+SharedRotation& SharedRotation::operator=(SharedRotation&& other)
+{
+  if (this == &other) return *this;
+  if (cache_ != NULL) RotationRegistry::shared().release(cache_);
+  cache_ = other.cache_;
+  other.cache_ = NULL;
+  return *this;
+}
+
+//Destructor
+SharedRotation::~SharedRotation()
+{
+  if (cache_ != NULL) RotationRegistry::shared().release(cache_);
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Rotation Registry Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Shares RotationCaches between everything that draws the same image at the
+  same size. Caches are keyed on the source surface, the scaled width and
+  height, the number of rotations and the filter, and are reference counted
+  so the last user to let go frees the cache.
+
+  SharedRotation is the handle objects hold. Copying one shares the cache, so
+  classes holding one can keep their default copy and assignment.
+
+  The registry also keeps the rotations of all caches within a byte budget.
+  Once per frame, enforceBudget frees the pages of rotations that were shown
+  least recently until the total fits. Freed rotations are recomputed in the
+  background if they are needed again.
+
+  If given a directory, the registry keeps finished caches there as atlas
+  files named by a hash of the source pixels, the scaled size, the rotation
+  count and the filter. Later runs map those files instead of rotating anything.
+
+  The registry is only touched from the main thread. The source surfaces are
+  matched by pointer, so they must outlive every cache made from them.
+*/
+
+#ifndef _rotationregistry_h_
+#define _rotationregistry_h_
+
+#include "SDL/SDL.h"
+#include "rotationcache.h"
+#include <map>
+#include <string>
+
+//Default limit on the pixel data held by all rotation caches together
+const long ROTATION_CACHE_BUDGET = 64L * 1024 * 1024;
+
+class RotationRegistry
+{
+ public:
+  //Finds the cache for source scaled by scale with count rotations, making it if needed
+  //Every acquire must be matched by a release
+  RotationCache* acquire(SDL_Surface* source, float scale, int count,
+			 RotationFilter filter = ROTATION_NEAREST);
+
+  //Adds or drops a reference to a cache from acquire, freeing it with the last one
+  void retain(RotationCache* cache);
+  void release(RotationCache* cache);
+
+  //Per-frame upkeep, saves finished caches and then enforces the budget
+  //Call once per frame after drawing, surfaces from rotation() are invalid afterwards
+  void update();
+
+  //Evicts the least recently shown pages until all caches fit in the budget
+  void enforceBudget();
+
+  //Starts writing out every cache that is finished and not yet on disk
+  void saveAtlases();
+
+  //Accessors
+  int caches() const {return entries_.size();}
+  int references() const;
+  long budget() const {return budget_;}
+  RotationStats stats() const;
+
+  //Mutators
+  //A budget of 0 or less turns eviction off
+  void setBudget(long bytes) {budget_ = bytes;}
+
+  //Sets where atlas files are kept, an empty string turns them off
+  //Only affects caches made afterwards
+  void setAtlasDirectory(const std::string& dir) {atlasDir_ = dir;}
+
+  //The registry shared by the whole game
+  static RotationRegistry& shared();
+
+ private:
+  struct Key
+  {
+    SDL_Surface* source;
+    int w, h, count;
+    RotationFilter filter;
+
+    bool operator<(const Key& k) const;
+  };
+
+  struct Entry
+  {
+    RotationCache* cache;
+    int refs;
+
+    //The atlas file for this cache, empty if there is none
+    std::string atlas;
+
+    //Whether the cache still has to be written to its atlas
+    bool unsaved;
+  };
+
+  //Constructors
+  RotationRegistry();
+
+  //Every live cache by key, and the key of each cache for releasing
+  std::map<Key, Entry> entries_;
+  std::map<RotationCache*, Key> keys_;
+
+  //Finds the atlas file name for a key, from the source pixels
+  std::string atlasPath(const Key& key) const;
+
+  //The most bytes all caches together may hold
+  long budget_;
+
+  //Where atlas files are kept, empty if they aren't
+  std::string atlasDir_;
+
+  //Pages evicted so far, including from caches since released
+  long evictions_;
+
+  //Hits and misses of caches since released, so the totals don't drop
+  long pastHits_;
+  long pastMisses_;
+};
+
+//A counted reference to a cache in the shared registry
+class SharedRotation
+{
+ public:
+  //Constructors/Destructor
+  SharedRotation(): cache_(NULL) {}
+  SharedRotation(SDL_Surface* source, float scale, int count,
+		 RotationFilter filter = ROTATION_NEAREST);
+  SharedRotation(const SharedRotation& other);
+  SharedRotation(SharedRotation&& other): cache_(other.cache_) {other.cache_ = NULL;}
+  SharedRotation& operator=(const SharedRotation& other);
+  SharedRotation& operator=(SharedRotation&& other);
+  ~SharedRotation();
+
+  //Access to the cache, which is NULL for a default constructed handle
+  RotationCache* get() const {return cache_;}
+  RotationCache* operator->() const {return cache_;}
+  bool empty() const {return cache_ == NULL;}
+
+ private:
+  RotationCache* cache_;
+};
+
+#endif
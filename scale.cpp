@@ -1,299 +1,620 @@
 /*
   Copyright (c) 2013 Auston Sterling
   See license.txt for copying permission.
-  
+
   -----Image Scaling Library Implementation-----
   Auston Sterling
   austonst@gmail.com
 
   A library containing a variety of algorithms for scaling images.
+
+  Every algorithm finds the source coordinates and weights for each column
+  and each row once, then fills the output a band of rows at a time. Large
+  images are split into bands that the shared ThreadPool works on together.
+  Bilinear and bicubic have SSE2 and AVX2 versions, picked at runtime, which
+  work on the color channels of a pixel as lanes. They do the same float
+  operations in the same order as the portable versions, so every version
+  gives exactly the same image.
 */
 
 #ifndef _scale_cpp_
 #define _scale_cpp_
 
+#include "scale.h"
+#include "threadpool.h"
 #include "SDL/SDL.h"
+#include <vector>
+#include <atomic>
 
-//Nearest Neighbor scaling, taking in a pointer to the source surface
-//and the scaling ratios, returning the new surface, which must
-//be manually cleaned up by the user.
-SDL_Surface* scaleNN(SDL_Surface* inimage, float xratio, float yratio)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCALE_X86 1
+#include <immintrin.h>
+#endif
+
+//Images with fewer output pixels than this are scaled on the calling thread
+const int SCALE_PARALLEL_PIXELS = 256 * 256;
+
+//The bands of rows an image is split into for each thread working on it
+const int SCALE_BANDS_PER_THREAD = 4;
+
+struct ScaleJob;
+typedef void (*ScaleRows)(const ScaleJob& job, int first, int last);
+
+//Everything needed to fill in the output, shared by every thread working on it
+struct ScaleJob
 {
-  //Verify ratios
-  if (xratio < 0.00001 || yratio < 0.00001) {return NULL;}
-  
-  //Calculate X and Y for new surface
-  int x = inimage->w*xratio;
-  int y = inimage->h*yratio;
+  //Pixels, and the distance between rows in pixels
+  const Uint32* in;
+  int inPitch;
+  Uint32* out;
+  int outPitch;
+  int w, h;
+
+  //Source columns and rows for each output column and row, and their weights
+  //Nearest neighbor uses one, bilinear two, bicubic four
+  std::vector<int> xi[4], yi[4];
+  std::vector<float> xw[4], yw[4];
+
+  //Fills in output rows [first, last)
+  ScaleRows rows;
+
+  //The next band of rows to be claimed, and how many there are
+  std::atomic<int> nextBand;
+  int bands;
+};
+
+//Clamps a source coordinate to the image
+static inline int clampIndex(int i, int size)
+{
+  return (i < 0) ? 0 : ((i >= size) ? size - 1 : i);
+}
 
-  //Find inverses of ratios
-  float invxr = 1/xratio;
-  float invyr = 1/yratio;
-  
-  //Create the new surface
-  SDL_Surface* outimage = SDL_CreateRGBSurface(SDL_SWSURFACE, x, y, inimage->format->BitsPerPixel, 0, 0, 0, 0);
+//Computes the four cubic B-spline weights for a point t of the way from p2 to p3
+//Each point's share of the color is its weight times the color, divided by 6
+static void splineWeights(float t, float* w)
+{
+  w[0] = (1-t)*(1-t)*(1-t);
+  w[1] = (3*t*t*t) - (6*t*t) + 4;
+  w[2] = (-3*t*t*t) + (3*t*t) + (3*t) + 1;
+  w[3] = t*t*t;
+}
 
-  //Lock surfaces
-  if (SDL_MUSTLOCK(inimage)) {SDL_LockSurface(inimage);}
-  if (SDL_MUSTLOCK(outimage)) {SDL_LockSurface(outimage);}
+//Blends four colors with spline weights, truncating each channel like SDL_Color does
+static inline Uint32 splineBlend(const Uint32* p, const float* w)
+{
+  Uint32 ret = 0;
+  for (int shift = 0; shift <= 16; shift += 8)
+    {
+      int c = (w[0]*int((p[0] >> shift) & 0xFF))/6 +
+	(w[1]*int((p[1] >> shift) & 0xFF))/6 +
+	(w[2]*int((p[2] >> shift) & 0xFF))/6 +
+	(w[3]*int((p[3] >> shift) & 0xFF))/6;
+      ret |= Uint32(c & 0xFF) << shift;
+    }
+  return ret;
+}
 
-  //Extract pixels
-  Uint32* inpixels = (Uint32*)inimage->pixels;
-  Uint32* outpixels = (Uint32*)outimage->pixels;
+//Nearest neighbor, copies the source pixel each output pixel falls in
+static void nnRows(const ScaleJob& job, int first, int last)
+{
+  const int* xs = &job.xi[0][0];
+  for (int j = first; j < last; j++)
+    {
+      const Uint32* src = job.in + job.yi[0][j] * job.inPitch;
+      Uint32* dst = job.out + j * job.outPitch;
+      for (int i = 0; i < job.w; i++)
+	{
+	  dst[i] = src[xs[i]];
+	}
+    }
+}
 
-  //Cycle through all pixels in the output image
-  for (int j = 0; j < y; j++)
+//Bilinear, portable version
+static void blRowsScalar(const ScaleJob& job, int first, int last)
+{
+  for (int j = first; j < last; j++)
     {
-      for (int i = 0; i < x; i++)
+      const Uint32* top = job.in + job.yi[0][j] * job.inPitch;
+      const Uint32* bottom = job.in + job.yi[1][j] * job.inPitch;
+      float ypart1 = job.yw[0][j];
+      float ypart2 = job.yw[1][j];
+      Uint32* dst = job.out + j * job.outPitch;
+      for (int i = 0; i < job.w; i++)
 	{
-	  outpixels[(j*x)+i] = inpixels[int((int(j*invyr)*inimage->w)+int(i*invxr))];
+	  int x0 = job.xi[0][i], x1 = job.xi[1][i];
+	  float xpart1 = job.xw[0][i], xpart2 = job.xw[1][i];
+	  Uint32 pixel = 0;
+	  for (int shift = 0; shift <= 16; shift += 8)
+	    {
+	      Uint8 c = (((top[x0] >> shift) & 0xFF) * xpart1 * ypart1) +
+		(((top[x1] >> shift) & 0xFF) * xpart2 * ypart1) +
+		(((bottom[x0] >> shift) & 0xFF) * xpart1 * ypart2) +
+		(((bottom[x1] >> shift) & 0xFF) * xpart2 * ypart2);
+	      pixel |= Uint32(c) << shift;
+	    }
+	  dst[i] = pixel;
 	}
     }
+}
 
-  //Unlock surfaces
-  if(SDL_MUSTLOCK(inimage)) {SDL_UnlockSurface(inimage);}
-  if(SDL_MUSTLOCK(outimage)) {SDL_UnlockSurface(outimage);}
+//Bicubic, portable version
+//Blends four columns in each of four rows, then blends the four results
+static void bcRowsScalar(const ScaleJob& job, int first, int last)
+{
+  for (int j = first; j < last; j++)
+    {
+      const Uint32* src[4];
+      float wy[4];
+      for (int k = 0; k < 4; k++)
+	{
+	  src[k] = job.in + job.yi[k][j] * job.inPitch;
+	  wy[k] = job.yw[k][j];
+	}
+      Uint32* dst = job.out + j * job.outPitch;
+      for (int i = 0; i < job.w; i++)
+	{
+	  float wx[4] = {job.xw[0][i], job.xw[1][i], job.xw[2][i], job.xw[3][i]};
+	  Uint32 across[4];
+	  for (int k = 0; k < 4; k++)
+	    {
+	      Uint32 p[4] = {src[k][job.xi[0][i]], src[k][job.xi[1][i]],
+			     src[k][job.xi[2][i]], src[k][job.xi[3][i]]};
+	      across[k] = splineBlend(p, wx);
+	    }
+	  dst[i] = splineBlend(across, wy);
+	}
+    }
+}
 
-  //Color key the new image if needed
-  if (inimage->flags & SDL_SRCCOLORKEY)
+#ifdef SCALE_X86
+//Spreads the four channels of a pixel into float lanes
+__attribute__((target("sse2")))
+static inline __m128 unpackPixel(Uint32 p)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+}
+
+//Truncates float lanes back into a pixel, dropping the unused top byte
+__attribute__((target("sse2")))
+static inline Uint32 packPixel(__m128 v)
+{
+  __m128i c = _mm_and_si128(_mm_cvttps_epi32(v), _mm_set1_epi32(0xFF));
+  c = _mm_packs_epi32(c, c);
+  c = _mm_packus_epi16(c, c);
+  return Uint32(_mm_cvtsi128_si32(c)) & 0x00FFFFFF;
+}
+
+
+//Computes one bilinear pixel, SSE2 version, with a lane per channel
+__attribute__((target("sse2")))
+static inline Uint32 blPixelSSE2(const ScaleJob& job, const Uint32* top, const Uint32* bottom,
+				 __m128 ypart1, __m128 ypart2, int i)
+{
+  int x0 = job.xi[0][i], x1 = job.xi[1][i];
+  __m128 xpart1 = _mm_set1_ps(job.xw[0][i]);
+  __m128 xpart2 = _mm_set1_ps(job.xw[1][i]);
+  __m128 sum = _mm_mul_ps(_mm_mul_ps(unpackPixel(top[x0]), xpart1), ypart1);
+  sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(unpackPixel(top[x1]), xpart2), ypart1));
+  sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(unpackPixel(bottom[x0]), xpart1), ypart2));
+  sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(unpackPixel(bottom[x1]), xpart2), ypart2));
+  return packPixel(sum);
+}
+
+//Bilinear, SSE2 version
+__attribute__((target("sse2")))
+static void blRowsSSE2(const ScaleJob& job, int first, int last)
+{
+  for (int j = first; j < last; j++)
     {
-      SDL_SetColorKey(outimage, SDL_RLEACCEL | SDL_SRCCOLORKEY, inimage->format->colorkey);
+      const Uint32* top = job.in + job.yi[0][j] * job.inPitch;
+      const Uint32* bottom = job.in + job.yi[1][j] * job.inPitch;
+      __m128 ypart1 = _mm_set1_ps(job.yw[0][j]);
+      __m128 ypart2 = _mm_set1_ps(job.yw[1][j]);
+      Uint32* dst = job.out + j * job.outPitch;
+      for (int i = 0; i < job.w; i++)
+	{
+	  dst[i] = blPixelSSE2(job, top, bottom, ypart1, ypart2, i);
+	}
     }
-  
-  //Return the SDL_Surface*
-  return outimage;
 }
 
-//Bilinear scaling function, taking in a source image, scaling ratios,
-//and returning a pointer to a new surface.
-SDL_Surface* scaleBL(SDL_Surface* inimage, float xratio, float yratio)
+//Blends four pixels with spline weights, SSE2 version
+//Truncates to whole channel values, as the portable version does between passes
+__attribute__((target("sse2")))
+static inline __m128 splineBlendSSE2(__m128 p0, __m128 p1, __m128 p2, __m128 p3, const float* w)
 {
-  //Verify ratios
-  if (xratio < 0.00001 || yratio < 0.00001) {return NULL;}
-  
-  //Calculate X and Y for new surface
-  int x = inimage->w*xratio;
-  int y = inimage->h*yratio;
+  __m128 six = _mm_set1_ps(6);
+  __m128 sum = _mm_div_ps(_mm_mul_ps(_mm_set1_ps(w[0]), p0), six);
+  sum = _mm_add_ps(sum, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(w[1]), p1), six));
+  sum = _mm_add_ps(sum, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(w[2]), p2), six));
+  sum = _mm_add_ps(sum, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(w[3]), p3), six));
+  __m128i c = _mm_and_si128(_mm_cvttps_epi32(sum), _mm_set1_epi32(0xFF));
+  return _mm_cvtepi32_ps(c);
+}
 
-  //Find inverses of ratios
-  float invxr = 1/xratio;
-  float invyr = 1/yratio;
-  
-  //Create the new surface
-  SDL_Surface* outimage = SDL_CreateRGBSurface(SDL_SWSURFACE, x, y, inimage->format->BitsPerPixel, 0, 0, 0, 0);
+//Computes one bicubic pixel, SSE2 version, with a lane per channel
+__attribute__((target("sse2")))
+static inline Uint32 bcPixelSSE2(const ScaleJob& job, const Uint32* const* src, const float* wy, int i)
+{
+  float wx[4] = {job.xw[0][i], job.xw[1][i], job.xw[2][i], job.xw[3][i]};
+  int x0 = job.xi[0][i], x1 = job.xi[1][i], x2 = job.xi[2][i], x3 = job.xi[3][i];
+  __m128 across[4];
+  for (int k = 0; k < 4; k++)
+    {
+      across[k] = splineBlendSSE2(unpackPixel(src[k][x0]), unpackPixel(src[k][x1]),
+				  unpackPixel(src[k][x2]), unpackPixel(src[k][x3]), wx);
+    }
+  return packPixel(splineBlendSSE2(across[0], across[1], across[2], across[3], wy));
+}
 
-  //Lock surfaces
-  if (SDL_MUSTLOCK(inimage)) {SDL_LockSurface(inimage);}
-  if (SDL_MUSTLOCK(outimage)) {SDL_LockSurface(outimage);}
+//Bicubic, SSE2 version
+__attribute__((target("sse2")))
+static void bcRowsSSE2(const ScaleJob& job, int first, int last)
+{
+  for (int j = first; j < last; j++)
+    {
+      const Uint32* src[4];
+      float wy[4];
+      for (int k = 0; k < 4; k++)
+	{
+	  src[k] = job.in + job.yi[k][j] * job.inPitch;
+	  wy[k] = job.yw[k][j];
+	}
+      Uint32* dst = job.out + j * job.outPitch;
+      for (int i = 0; i < job.w; i++)
+	{
+	  dst[i] = bcPixelSSE2(job, src, wy, i);
+	}
+    }
+}
 
-  //Extract pixels
-  Uint32* inpixels = (Uint32*)inimage->pixels;
-  Uint32* outpixels = (Uint32*)outimage->pixels;
-
-  //Reusable vars
-  float xorig;
-  float yorig;
-  int xfloor;
-  int yfloor;
-  Uint32 pix[2][2];
-  Uint8 rgb[5][3];
-  float xpart1;
-  float xpart2;
-  float ypart1;
-  float ypart2;
-  
-
-  //Cycle through all pixels in the output image
-  for (int j = 0; j < y; j++)
+//Spreads the channels of two pixels into eight float lanes, a in the low half
+__attribute__((target("avx2")))
+static inline __m256 unpackPair(Uint32 a, Uint32 b)
+{
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_set_epi32(0, 0, b, a)));
+}
+
+//Broadcasts one weight to the low half and another to the high half
+__attribute__((target("avx2")))
+static inline __m256 splitWeight(float lo, float hi)
+{
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)), _mm_set1_ps(hi), 1);
+}
+
+//Bilinear, AVX2 version, two pixels at a time
+__attribute__((target("avx2")))
+static void blRowsAVX2(const ScaleJob& job, int first, int last)
+{
+  for (int j = first; j < last; j++)
     {
-      for (int i = 0; i < x; i++)
+      const Uint32* top = job.in + job.yi[0][j] * job.inPitch;
+      const Uint32* bottom = job.in + job.yi[1][j] * job.inPitch;
+      __m256 ypart1 = _mm256_set1_ps(job.yw[0][j]);
+      __m256 ypart2 = _mm256_set1_ps(job.yw[1][j]);
+      Uint32* dst = job.out + j * job.outPitch;
+      int i = 0;
+      for (; i + 2 <= job.w; i += 2)
 	{
-	  //Find corresponding point in source
-	  xorig = float(i) * invxr;
-	  yorig = float(j) * invyr;
-
-	  //Find top left pixel coordinates
-	  xfloor = int(xorig);
-	  yfloor = int(yorig);
-
-	  //Store pixel values themselves
-	  pix[0][0] = inpixels[(yfloor * inimage->w) + xfloor];
-	  pix[1][0] = inpixels[(yfloor * inimage->w) + xfloor + 1];
-	  pix[0][1] = inpixels[((yfloor + 1) * inimage->w) + xfloor];
-	  pix[1][1] = inpixels[((yfloor + 1) * inimage->w) + xfloor + 1];
-
-	  //Extract RGB values
-	  rgb[0][0] = Uint8(pix[0][0] >> 16);
-	  rgb[0][1] = Uint8(pix[0][0] >> 8);
-	  rgb[0][2] = Uint8(pix[0][0] >> 0);
-	  rgb[1][0] = Uint8(pix[1][0] >> 16);
-	  rgb[1][1] = Uint8(pix[1][0] >> 8);
-	  rgb[1][2] = Uint8(pix[1][0] >> 0);
-	  rgb[2][0] = Uint8(pix[0][1] >> 16);
-	  rgb[2][1] = Uint8(pix[0][1] >> 8);
-	  rgb[2][2] = Uint8(pix[0][1] >> 0);
-	  rgb[3][0] = Uint8(pix[1][1] >> 16);
-	  rgb[3][1] = Uint8(pix[1][1] >> 8);
-	  rgb[3][2] = Uint8(pix[1][1] >> 0);
-
-	  //Calculate intermediate values
-	  xpart1 = xfloor - xorig + 1;
-	  xpart2 = xorig - xfloor;
-	  ypart1 = yfloor - yorig + 1;
-	  ypart2 = yorig - yfloor;
-
-	  rgb[4][0] = (rgb[0][0] * xpart1 * ypart1) +
-	              (rgb[1][0] * xpart2 * ypart1) +
-	              (rgb[2][0] * xpart1 * ypart2) +
-     	              (rgb[3][0] * xpart2 * ypart2);
-	  rgb[4][1] = (rgb[0][1] * xpart1 * ypart1) +
-	              (rgb[1][1] * xpart2 * ypart1) +
-	              (rgb[2][1] * xpart1 * ypart2) +
-     	              (rgb[3][1] * xpart2 * ypart2);
-	  rgb[4][2] = (rgb[0][2] * xpart1 * ypart1) +
-	              (rgb[1][2] * xpart2 * ypart1) +
-	              (rgb[2][2] * xpart1 * ypart2) +
-     	              (rgb[3][2] * xpart2 * ypart2);
-
-	  //Copy it over to the destination image
-	  outpixels[(j * x) + i] = SDL_MapRGB(outimage->format,
-					     rgb[4][0], rgb[4][1], rgb[4][2]);
+	  int a0 = job.xi[0][i], a1 = job.xi[1][i];
+	  int b0 = job.xi[0][i+1], b1 = job.xi[1][i+1];
+	  __m256 xpart1 = splitWeight(job.xw[0][i], job.xw[0][i+1]);
+	  __m256 xpart2 = splitWeight(job.xw[1][i], job.xw[1][i+1]);
+	  __m256 sum = _mm256_mul_ps(_mm256_mul_ps(unpackPair(top[a0], top[b0]), xpart1), ypart1);
+	  sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_mul_ps(unpackPair(top[a1], top[b1]), xpart2), ypart1));
+	  sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_mul_ps(unpackPair(bottom[a0], bottom[b0]), xpart1), ypart2));
+	  sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_mul_ps(unpackPair(bottom[a1], bottom[b1]), xpart2), ypart2));
+	  dst[i] = packPixel(_mm256_castps256_ps128(sum));
+	  dst[i+1] = packPixel(_mm256_extractf128_ps(sum, 1));
+	}
+
+      //An odd pixel left over at the end
+      if (i < job.w)
+	{
+	  dst[i] = blPixelSSE2(job, top, bottom, _mm256_castps256_ps128(ypart1),
+			       _mm256_castps256_ps128(ypart2), i);
 	}
     }
-  
-  //Unlock surfaces
-  if(SDL_MUSTLOCK(inimage)) {SDL_UnlockSurface(inimage);}
-  if(SDL_MUSTLOCK(outimage)) {SDL_UnlockSurface(outimage);}
+}
 
-  //Color key the new image if needed
-  if (inimage->flags & SDL_SRCCOLORKEY)
+//Blends four pairs of pixels with spline weights, AVX2 version
+//Each half of w holds the weights for one of the pair
+__attribute__((target("avx2")))
+static inline __m256 splineBlendAVX2(__m256 p0, __m256 p1, __m256 p2, __m256 p3, const __m256* w)
+{
+  __m256 six = _mm256_set1_ps(6);
+  __m256 sum = _mm256_div_ps(_mm256_mul_ps(w[0], p0), six);
+  sum = _mm256_add_ps(sum, _mm256_div_ps(_mm256_mul_ps(w[1], p1), six));
+  sum = _mm256_add_ps(sum, _mm256_div_ps(_mm256_mul_ps(w[2], p2), six));
+  sum = _mm256_add_ps(sum, _mm256_div_ps(_mm256_mul_ps(w[3], p3), six));
+  __m256i c = _mm256_and_si256(_mm256_cvttps_epi32(sum), _mm256_set1_epi32(0xFF));
+  return _mm256_cvtepi32_ps(c);
+}
+
+//Bicubic, AVX2 version, two pixels at a time
+__attribute__((target("avx2")))
+static void bcRowsAVX2(const ScaleJob& job, int first, int last)
+{
+  for (int j = first; j < last; j++)
     {
-      SDL_SetColorKey(outimage, SDL_RLEACCEL | SDL_SRCCOLORKEY, inimage->format->colorkey);
+      const Uint32* src[4];
+      float wy[4];
+      __m256 wy8[4];
+      for (int k = 0; k < 4; k++)
+	{
+	  src[k] = job.in + job.yi[k][j] * job.inPitch;
+	  wy[k] = job.yw[k][j];
+	  wy8[k] = _mm256_set1_ps(wy[k]);
+	}
+      Uint32* dst = job.out + j * job.outPitch;
+      int i = 0;
+      for (; i + 2 <= job.w; i += 2)
+	{
+	  __m256 wx[4];
+	  int a[4], b[4];
+	  for (int k = 0; k < 4; k++)
+	    {
+	      wx[k] = splitWeight(job.xw[k][i], job.xw[k][i+1]);
+	      a[k] = job.xi[k][i];
+	      b[k] = job.xi[k][i+1];
+	    }
+	  __m256 across[4];
+	  for (int k = 0; k < 4; k++)
+	    {
+	      const Uint32* row = src[k];
+	      across[k] = splineBlendAVX2(unpackPair(row[a[0]], row[b[0]]), unpackPair(row[a[1]], row[b[1]]),
+					  unpackPair(row[a[2]], row[b[2]]), unpackPair(row[a[3]], row[b[3]]), wx);
+	    }
+	  __m256 sum = splineBlendAVX2(across[0], across[1], across[2], across[3], wy8);
+	  dst[i] = packPixel(_mm256_castps256_ps128(sum));
+	  dst[i+1] = packPixel(_mm256_extractf128_ps(sum, 1));
+	}
+
+      //An odd pixel left over at the end
+      if (i < job.w)
+	{
+	  dst[i] = bcPixelSSE2(job, src, wy, i);
+	}
     }
-  
-  //Return the SDL_Surface*
-  return outimage;
 }
+#endif
 
-//Helper function, computes the value of the color at the given ratio between the
-//two other points
-SDL_Color bspline(SDL_Color p1, SDL_Color p2, SDL_Color p3, SDL_Color p4, float t)
-{
-  //Fill in spline formula
-  int r = ((1-t)*(1-t)*(1-t)*p1.r)/6 +
-    ((3*t*t*t) - (6*t*t) + 4)*p2.r/6 +
-    ((-3*t*t*t) + (3*t*t) + (3*t) + 1)*p3.r/6 +
-    (t*t*t*p4.r)/6;
-  int g = ((1-t)*(1-t)*(1-t)*p1.g)/6 +
-    ((3*t*t*t) - (6*t*t) + 4)*p2.g/6 +
-    ((-3*t*t*t) + (3*t*t) + (3*t) + 1)*p3.g/6 +
-    (t*t*t*p4.g)/6;
-  int b = ((1-t)*(1-t)*(1-t)*p1.b)/6 +
-    ((3*t*t*t) - (6*t*t) + 4)*p2.b/6 +
-    ((-3*t*t*t) + (3*t*t) + (3*t) + 1)*p3.b/6 +
-    (t*t*t*p4.b)/6;
-
-  //Copy values out and return
-  SDL_Color ret;
-  ret.r = r; ret.g = g; ret.b = b;
-  return ret;
+//Picks the fastest versions the CPU supports
+static ScaleRows chooseBilinear()
+{
+#ifdef SCALE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return blRowsAVX2;
+  if (__builtin_cpu_supports("sse2")) return blRowsSSE2;
+#endif
+  return blRowsScalar;
 }
 
-//Converts a Uint32 in form ARGB to a SDL_Color
-SDL_Color toColor(Uint32 incolor)
+static ScaleRows chooseBicubic()
 {
-  //Create the SDL_Color
-  SDL_Color outcolor;
+#ifdef SCALE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return bcRowsAVX2;
+  if (__builtin_cpu_supports("sse2")) return bcRowsSSE2;
+#endif
+  return bcRowsScalar;
+}
 
-  //Copy over values
-  outcolor.r = incolor >> 16;
-  outcolor.g = incolor >> 8;
-  outcolor.b = incolor >> 0;
+static const ScaleRows bilinearRows = chooseBilinear();
+static const ScaleRows bicubicRows = chooseBicubic();
 
-  //Return it
-  return outcolor;
+//Job run by the thread pool, fills in bands until none are left
+static void scaleBands(void* data, int)
+{
+  ScaleJob& job = *(ScaleJob*)data;
+  int band;
+  while ((band = job.nextBand++) < job.bands)
+    {
+      int first = job.h * band / job.bands;
+      int last = job.h * (band + 1) / job.bands;
+      job.rows(job, first, last);
+    }
 }
 
-//Bicubic scale
-SDL_Surface* scaleBC(SDL_Surface* inimage, float xratio, float yratio)
+//Fills in the whole output, splitting large images between the thread pool
+//The calling thread claims bands too, so it never sits waiting on a busy queue
+static void runJob(ScaleJob& job)
 {
-  //Verify ratios
-  if (xratio < 0.00001 || yratio < 0.00001) {return NULL;}
-  
-  //Calculate X and Y for new surface
-  int x = inimage->w*xratio;
-  int y = inimage->h*yratio;
+  ThreadPool& pool = ThreadPool::shared();
+  if (job.w * job.h < SCALE_PARALLEL_PIXELS || pool.threads() == 0)
+    {
+      job.rows(job, 0, job.h);
+      return;
+    }
+
+  job.bands = (pool.threads() + 1) * SCALE_BANDS_PER_THREAD;
+  if (job.bands > job.h) job.bands = job.h;
+  job.nextBand = 0;
+  for (int t = 0; t < pool.threads(); t++)
+    {
+      pool.submit(scaleBands, &job, 0);
+    }
+  scaleBands(&job, 0);
+
+  //Workers that never got to start have nothing left to do
+  pool.cancel(&job);
+}
+
+//Finds the source rows or columns and weights for each of size outputs
+//Nearest neighbor and bilinear, taps is 1 or 2
+static void linearTaps(int size, int insize, float inv, int taps, std::vector<int>* idx, std::vector<float>* wt)
+{
+  for (int k = 0; k < taps; k++)
+    {
+      idx[k].resize(size);
+      wt[k].resize(size);
+    }
+  for (int i = 0; i < size; i++)
+    {
+      float orig = float(i) * inv;
+      int floor = int(orig);
+      idx[0][i] = clampIndex(floor, insize);
+      wt[0][i] = floor - orig + 1;
+      if (taps < 2) continue;
+      idx[1][i] = clampIndex(floor + 1, insize);
+      wt[1][i] = orig - floor;
+    }
+}
+
+//Finds the four source rows or columns and spline weights for each of size outputs
+static void cubicTaps(int size, int insize, float inv, std::vector<int>* idx, std::vector<float>* wt)
+{
+  for (int k = 0; k < 4; k++)
+    {
+      idx[k].resize(size);
+      wt[k].resize(size);
+    }
+  for (int i = 0; i < size; i++)
+    {
+      float orig = float(i) * inv;
+      int floor = int(orig);
+      float w[4];
+      splineWeights(orig - floor, w);
+      for (int k = 0; k < 4; k++)
+	{
+	  idx[k][i] = clampIndex(floor - 1 + k, insize);
+	  wt[k][i] = w[k];
+	}
+    }
+}
+
+//The algorithms, for scaleInto
+enum ScaleMethod {SCALE_NN, SCALE_BL, SCALE_BC};
+
+//Scales inimage into outimage with the given algorithm and ratios
+//Both must be 32 bit surfaces
+static bool scaleInto(SDL_Surface* inimage, SDL_Surface* outimage,
+		      float xratio, float yratio, ScaleMethod method)
+{
+  //Verify surfaces and ratios
+  if (inimage == NULL || outimage == NULL) {return false;}
+  if (xratio < 0.00001 || yratio < 0.00001) {return false;}
+  if (inimage->format->BytesPerPixel != 4 || outimage->format->BytesPerPixel != 4) {return false;}
+  if (inimage->w <= 0 || inimage->h <= 0) {return false;}
 
   //Find inverses of ratios
   float invxr = 1/xratio;
   float invyr = 1/yratio;
-  
-  //Create the new surface
-  SDL_Surface* outimage = SDL_CreateRGBSurface(SDL_SWSURFACE, x, y, inimage->format->BitsPerPixel, 0, 0, 0, 0);
+
+  //Work out where every output column and row comes from
+  ScaleJob job;
+  job.w = outimage->w;
+  job.h = outimage->h;
+  switch (method)
+    {
+    case SCALE_NN:
+      linearTaps(job.w, inimage->w, invxr, 1, job.xi, job.xw);
+      linearTaps(job.h, inimage->h, invyr, 1, job.yi, job.yw);
+      job.rows = nnRows;
+      break;
+    case SCALE_BL:
+      linearTaps(job.w, inimage->w, invxr, 2, job.xi, job.xw);
+      linearTaps(job.h, inimage->h, invyr, 2, job.yi, job.yw);
+      job.rows = bilinearRows;
+      break;
+    case SCALE_BC:
+      cubicTaps(job.w, inimage->w, invxr, job.xi, job.xw);
+      cubicTaps(job.h, inimage->h, invyr, job.yi, job.yw);
+      job.rows = bicubicRows;
+      break;
+    }
 
   //Lock surfaces
   if (SDL_MUSTLOCK(inimage)) {SDL_LockSurface(inimage);}
   if (SDL_MUSTLOCK(outimage)) {SDL_LockSurface(outimage);}
 
   //Extract pixels
-  Uint32* inpixels = (Uint32*)inimage->pixels;
-  Uint32* outpixels = (Uint32*)outimage->pixels;
+  job.in = (const Uint32*)inimage->pixels;
+  job.inPitch = inimage->pitch / 4;
+  job.out = (Uint32*)outimage->pixels;
+  job.outPitch = outimage->pitch / 4;
 
-  //Other variables
-  float xorig, yorig;
-  int xfloor, yfloor;
-
-  //Cycle through all pixels in the output image
-  for (int j = 0; j < y; j++)
-    {
-      for (int i = 0; i < x; i++)
-	{
-	  //Find corresponding point in source
-	  xorig = float(i) * invxr;
-	  yorig = float(j) * invyr;
-
-	  //Find top left pixel coordinates
-	  xfloor = int(xorig);
-	  yfloor = int(yorig);
-
-	  //Call bspline on what's needed
-	  //Calls within calls to handle bilinearity
-	  SDL_Color newcolor;
-	  newcolor = bspline(bspline(toColor(inpixels[((yfloor-1<0?0:yfloor-1) * inimage->w) + (xfloor-1<0?0:xfloor-1)]),
-				     toColor(inpixels[((yfloor-1<0?0:yfloor-1) * inimage->w) + (xfloor<0?0:xfloor)]),
-				     toColor(inpixels[((yfloor-1<0?0:yfloor-1) * inimage->w) + (xfloor+1>=inimage->h?inimage->h-1:xfloor+1)]),
-				     toColor(inpixels[((yfloor-1<0?0:yfloor-1) * inimage->w) + (xfloor+2>=inimage->h?inimage->h-1:xfloor+2)]), xorig-xfloor),
-			     bspline(toColor(inpixels[((yfloor<0?0:yfloor) * inimage->w) + (xfloor-1<0?0:xfloor-1)]),
-				     toColor(inpixels[((yfloor<0?0:yfloor) * inimage->w) + (xfloor<0?0:xfloor)]),
-				     toColor(inpixels[((yfloor<0?0:yfloor) * inimage->w) + (xfloor+1>=inimage->h?inimage->h-1:xfloor+1)]),
-				     toColor(inpixels[((yfloor<0?0:yfloor) * inimage->w) + (xfloor+2>=inimage->h?inimage->h-1:xfloor+2)]), xorig-xfloor),
-			     bspline(toColor(inpixels[((yfloor+1>=inimage->w?inimage->w-1:yfloor+1) * inimage->w) + (xfloor-1<0?0:xfloor-1)]),
-				     toColor(inpixels[((yfloor+1>=inimage->w?inimage->w-1:yfloor+1) * inimage->w) + (xfloor<0?0:xfloor)]),
-				     toColor(inpixels[((yfloor+1>=inimage->w?inimage->w-1:yfloor+1) * inimage->w) + (xfloor+1>=inimage->h?inimage->h-1:xfloor+1)]),
-				     toColor(inpixels[((yfloor+1>=inimage->w?inimage->w-1:yfloor+1) * inimage->w) + (xfloor+2>=inimage->h?inimage->h-1:xfloor+2)]), xorig-xfloor),
-			     bspline(toColor(inpixels[((yfloor+2>=inimage->w?inimage->w-1:yfloor+2) * inimage->w) + (xfloor-1<0?0:xfloor-1)]),
-				     toColor(inpixels[((yfloor+2>=inimage->w?inimage->w-1:yfloor+2) * inimage->w) + (xfloor<0?0:xfloor)]),
-				     toColor(inpixels[((yfloor+2>=inimage->w?inimage->w-1:yfloor+2) * inimage->w) + (xfloor+1>=inimage->h?inimage->h-1:xfloor+1)]),
-				     toColor(inpixels[((yfloor+2>=inimage->w?inimage->w-1:yfloor+2) * inimage->w) + (xfloor+2>=inimage->h?inimage->h-1:xfloor+2)]), xorig-xfloor),
-			     yorig-yfloor);
-
-	  //Write the output pixel
-	  outpixels[(j * x) + i] = SDL_MapRGB(outimage->format, newcolor.r, newcolor.g, newcolor.b);
-	}
-    }
+  if (job.w > 0 && job.h > 0) runJob(job);
 
   //Unlock surfaces
   if(SDL_MUSTLOCK(inimage)) {SDL_UnlockSurface(inimage);}
   if(SDL_MUSTLOCK(outimage)) {SDL_UnlockSurface(outimage);}
 
+  return true;
+}
+
+//Creates a surface for inimage scaled by the ratios, and scales into it
+static SDL_Surface* scaleNew(SDL_Surface* inimage, float xratio, float yratio, ScaleMethod method)
+{
+  //Verify ratios
+  if (xratio < 0.00001 || yratio < 0.00001) {return NULL;}
+
+  //Calculate X and Y for new surface
+  int x = inimage->w*xratio;
+  int y = inimage->h*yratio;
+
+  //Create the new surface
+  SDL_Surface* outimage = SDL_CreateRGBSurface(SDL_SWSURFACE, x, y, inimage->format->BitsPerPixel, 0, 0, 0, 0);
+  if (outimage == NULL) {return NULL;}
+  if (!scaleInto(inimage, outimage, xratio, yratio, method))
+    {
+      SDL_FreeSurface(outimage);
+      return NULL;
+    }
+
   //Color key the new image if needed
   if (inimage->flags & SDL_SRCCOLORKEY)
     {
       SDL_SetColorKey(outimage, SDL_RLEACCEL | SDL_SRCCOLORKEY, inimage->format->colorkey);
     }
-  
+
   //Return the SDL_Surface*
   return outimage;
 }
 
+//Nearest Neighbor scaling, taking in a pointer to the source surface
+//and the scaling ratios, returning the new surface, which must
+//be manually cleaned up by the user.
+SDL_Surface* scaleNN(SDL_Surface* inimage, float xratio, float yratio)
+{
+  return scaleNew(inimage, xratio, yratio, SCALE_NN);
+}
+
+//Bilinear scaling function, taking in a source image, scaling ratios,
+//and returning a pointer to a new surface.
+SDL_Surface* scaleBL(SDL_Surface* inimage, float xratio, float yratio)
+{
+  return scaleNew(inimage, xratio, yratio, SCALE_BL);
+}
+
+//Bicubic scale
+SDL_Surface* scaleBC(SDL_Surface* inimage, float xratio, float yratio)
+{
+  return scaleNew(inimage, xratio, yratio, SCALE_BC);
+}
+
+//Scaling into an existing surface, the ratios come from the two sizes
+bool scaleNNInto(SDL_Surface* inimage, SDL_Surface* outimage)
+{
+  if (inimage == NULL || outimage == NULL || inimage->w <= 0 || inimage->h <= 0) {return false;}
+  return scaleInto(inimage, outimage, float(outimage->w)/float(inimage->w),
+		   float(outimage->h)/float(inimage->h), SCALE_NN);
+}
+
+bool scaleBLInto(SDL_Surface* inimage, SDL_Surface* outimage)
+{
+  if (inimage == NULL || outimage == NULL || inimage->w <= 0 || inimage->h <= 0) {return false;}
+  return scaleInto(inimage, outimage, float(outimage->w)/float(inimage->w),
+		   float(outimage->h)/float(inimage->h), SCALE_BL);
+}
+
+bool scaleBCInto(SDL_Surface* inimage, SDL_Surface* outimage)
+{
+  if (inimage == NULL || outimage == NULL || inimage->w <= 0 || inimage->h <= 0) {return false;}
+  return scaleInto(inimage, outimage, float(outimage->w)/float(inimage->w),
+		   float(outimage->h)/float(inimage->h), SCALE_BC);
+}
+
 #endif
@@ -12,6 +12,8 @@
   - Bilinear
   - Bicubic
   - Smooth Bresenham
+
+  Large images are scaled by several threads from the shared ThreadPool.
 */
 
 #ifndef _scale_h_
@@ -20,27 +22,27 @@
 #include "SDL/SDL.h"
 
 //Nearest Neighbor
-//Call given new width and height
-SDL_Surface* scaleNN(SDL_Surface* inimage, int w, int h)
-{return scaleNN(inimage, float(w)/float(inimage->w), float(h)/float(inimage->h));}
-
 //Call given two ratios
 SDL_Surface* scaleNN(SDL_Surface* inimage, float xratio, float yratio);
 
 //Call given single ratio
-SDL_Surface* scaleNN(SDL_Surface* inimage, float ratio)
+inline SDL_Surface* scaleNN(SDL_Surface* inimage, float ratio)
 {return scaleNN(inimage, ratio, ratio);}
 
+//Call given new width and height
+inline SDL_Surface* scaleNN(SDL_Surface* inimage, int w, int h)
+{return scaleNN(inimage, float(w)/float(inimage->w), float(h)/float(inimage->h));}
+
 //Bilinear
 //Call given two ratios
 SDL_Surface* scaleBL(SDL_Surface* inimage, float xratio, float yratio);
 
 //Call given one ratio
-SDL_Surface* scaleBL(SDL_Surface* inimage, float ratio)
+inline SDL_Surface* scaleBL(SDL_Surface* inimage, float ratio)
 {return scaleBL(inimage, ratio, ratio);}
 
 //Call given new width and height
-SDL_Surface* scaleBL(SDL_Surface* inimage, int w, int h)
+inline SDL_Surface* scaleBL(SDL_Surface* inimage, int w, int h)
 {return scaleBL(inimage, float(w)/float(inimage->w), float(h)/float(inimage->h));}
 
 //Bicubic
@@ -48,11 +50,18 @@ SDL_Surface* scaleBL(SDL_Surface* inimage, int w, int h)
 SDL_Surface* scaleBC(SDL_Surface* inimage, float xratio, float yratio);
 
 //Call given one ratio
-SDL_Surface* scaleBC(SDL_Surface* inimage, float ratio)
+inline SDL_Surface* scaleBC(SDL_Surface* inimage, float ratio)
 {return scaleBC(inimage, ratio, ratio);}
 
 //Call given new width and height
-SDL_Surface* scaleBC(SDL_Surface* inimage, int w, int h)
+inline SDL_Surface* scaleBC(SDL_Surface* inimage, int w, int h)
 {return scaleBC(inimage, float(w)/float(inimage->w), float(h)/float(inimage->h));}
 
+//Scaling into a preallocated surface, resized to fill all of outimage
+//Both surfaces must be 32 bits per pixel. The output's color key is left alone.
+//Returns false without touching outimage if the scale can't be done.
+bool scaleNNInto(SDL_Surface* inimage, SDL_Surface* outimage);
+bool scaleBLInto(SDL_Surface* inimage, SDL_Surface* outimage);
+bool scaleBCInto(SDL_Surface* inimage, SDL_Surface* outimage);
+
 #endif
@@ -0,0 +1,119 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----Scaling Benchmark-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Times the portable, SSE2 and AVX2 row functions for bilinear and bicubic
+  scaling on a large image, then the chosen one on one thread against the
+  banded thread pool path. Every version must give exactly the same pixels.
+  Build with "make bench".
+*/
+
+//The row functions are private to the library, so take them straight from its source
+#include "scale.cpp"
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+//A source image scaled up to twice its size
+const int BENCH_IN = 1000;
+const int BENCH_OUT = 2000;
+
+//Seconds of wall time, since the banded path uses several threads
+static double now()
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+//Sets up a job scaling in into out with the given method, without choosing rows
+static void setup(ScaleJob& job, ScaleMethod method, const std::vector<Uint32>& in, std::vector<Uint32>& out)
+{
+  float inv = float(BENCH_IN) / float(BENCH_OUT);
+  job.in = &in[0];
+  job.inPitch = BENCH_IN;
+  job.out = &out[0];
+  job.outPitch = BENCH_OUT;
+  job.w = job.h = BENCH_OUT;
+  if (method == SCALE_BC)
+    {
+      cubicTaps(job.w, BENCH_IN, inv, job.xi, job.xw);
+      cubicTaps(job.h, BENCH_IN, inv, job.yi, job.yw);
+    }
+  else
+    {
+      linearTaps(job.w, BENCH_IN, inv, 2, job.xi, job.xw);
+      linearTaps(job.h, BENCH_IN, inv, 2, job.yi, job.yw);
+    }
+}
+
+//Scales with rows on this thread alone, or banded across the pool
+//Returns the seconds taken and leaves the image in out
+static double run(ScaleMethod method, ScaleRows rows, bool banded,
+		  const std::vector<Uint32>& in, std::vector<Uint32>& out)
+{
+  ScaleJob job;
+  setup(job, method, in, out);
+  job.rows = rows;
+  double start = now();
+  if (banded) runJob(job);
+  else rows(job, 0, job.h);
+  return now() - start;
+}
+
+//Times one version against the portable one's output, false if they differ
+static bool check(const char* name, ScaleMethod method, ScaleRows rows, bool banded,
+		  const std::vector<Uint32>& in, const std::vector<Uint32>& expect)
+{
+  std::vector<Uint32> out(expect.size());
+  double t = run(method, rows, banded, in, out);
+  bool same = (out == expect);
+  std::cout << "  " << name << ": " << t << "s" << (same ? "" : ", OUTPUT DIFFERS") << std::endl;
+  return same;
+}
+
+//Runs every version of one algorithm
+static bool bench(const char* name, ScaleMethod method, ScaleRows scalar, ScaleRows sse2,
+		  ScaleRows avx2, ScaleRows chosen, const std::vector<Uint32>& in)
+{
+  std::cout << name << std::endl;
+  std::vector<Uint32> expect(BENCH_OUT * BENCH_OUT);
+  std::cout << "  scalar: " << run(method, scalar, false, in, expect) << "s" << std::endl;
+
+  bool ok = true;
+#ifdef SCALE_X86
+  if (__builtin_cpu_supports("sse2")) ok = check("sse2", method, sse2, false, in, expect) && ok;
+  else std::cout << "  sse2: not supported" << std::endl;
+  if (__builtin_cpu_supports("avx2")) ok = check("avx2", method, avx2, false, in, expect) && ok;
+  else std::cout << "  avx2: not supported" << std::endl;
+#endif
+  ok = check("chosen, one thread", method, chosen, false, in, expect) && ok;
+  ok = check("chosen, banded", method, chosen, true, in, expect) && ok;
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<Uint32> in(BENCH_IN * BENCH_IN);
+  std::srand(1);
+  for (unsigned int i = 0; i < in.size(); i++)
+    {
+      in[i] = Uint32(std::rand()) & 0xFFFFFF;
+    }
+
+  std::cout << BENCH_IN << "x" << BENCH_IN << " scaled to " << BENCH_OUT << "x" << BENCH_OUT
+	    << ", " << ThreadPool::shared().threads() << " pool threads" << std::endl;
+#ifdef SCALE_X86
+  __builtin_cpu_init();
+  bool ok = bench("bilinear", SCALE_BL, blRowsScalar, blRowsSSE2, blRowsAVX2, bilinearRows, in);
+  ok = bench("bicubic", SCALE_BC, bcRowsScalar, bcRowsSSE2, bcRowsAVX2, bicubicRows, in) && ok;
+#else
+  bool ok = bench("bilinear", SCALE_BL, blRowsScalar, NULL, NULL, bilinearRows, in);
+  ok = bench("bicubic", SCALE_BC, bcRowsScalar, NULL, NULL, bicubicRows, in) && ok;
+#endif
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----SharedSurface Class-----
+  Auston Sterling
+  austonst@gmail.com
+
+  A counted reference to an SDL_Surface, using the surface's own refcount.
+  Copies share the surface and the last one to go frees it, so a class
+  holding one can keep its default copy, move and destructor. The count isn't
+  locked, so every reference to a surface must stay on one thread.
+*/
+
+#ifndef _sharedsurface_h_
+#define _sharedsurface_h_
+
+#include "SDL/SDL.h"
+
+class SharedSurface
+{
+ public:
+  //Constructors/Destructor
+  //Takes over the reference to surf, which may be NULL
+  SharedSurface(): surf_(NULL) {}
+  explicit SharedSurface(SDL_Surface* surf): surf_(surf) {}
+  SharedSurface(const SharedSurface& other): surf_(other.surf_) {
+    if (surf_ != NULL) surf_->refcount++; }
+  SharedSurface(SharedSurface&& other): surf_(other.surf_) {
+    other.surf_ = NULL; }
+  ~SharedSurface() {if (surf_ != NULL) SDL_FreeSurface(surf_);}
+
+  //Assignment operators
+  SharedSurface& operator=(const SharedSurface& other) {
+    if (other.surf_ != NULL) other.surf_->refcount++;
+    if (surf_ != NULL) SDL_FreeSurface(surf_);
+    surf_ = other.surf_;
+    return *this; }
+  SharedSurface& operator=(SharedSurface&& other) {
+    if (this != &other) {
+      if (surf_ != NULL) SDL_FreeSurface(surf_);
+      surf_ = other.surf_;
+      other.surf_ = NULL; }
+    return *this; }
+
+  //Accessors
+  SDL_Surface* get() const {return surf_;}
+  bool empty() const {return surf_ == NULL;}
+
+ private:
+  SDL_Surface* surf_;
+};
+
+#endif
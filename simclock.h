@@ -0,0 +1,48 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----SimClock Class-----
+  Auston Sterling
+  austonst@gmail.com
+
+  A class for keeping track of simulated time. One clock is advanced once per
+  simulation step and passed to everything that updates, so every object sees
+  the same dt and the simulation can run at any speed relative to wall-clock
+  time.
+*/
+
+#ifndef _simclock_h_
+#define _simclock_h_
+
+//The length of one fixed simulation step, in milliseconds
+const int SIM_STEP = 10;
+
+//The most simulated time the main loop will try to catch up on in one frame
+const int SIM_MAX_CATCHUP = 250;
+
+class SimClock
+{
+ public:
+  //Constructors
+  SimClock() : time_(0), dt_(0) {}
+
+  //Accessors
+  int time() const {return time_;}
+  int dt() const {return dt_;}
+  float seconds() const {return dt_ / 1000.0;}
+
+  //Moves the clock forward by dt milliseconds
+  void advance(int dt) {
+    dt_ = dt;
+    time_ += dt; }
+
+ private:
+  //The total simulated time, in milliseconds
+  int time_;
+
+  //The length of the current step, in milliseconds
+  int dt_;
+};
+
+#endif
@@ -0,0 +1,147 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----ThreadPool Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the ThreadPool class.
+*/
+
+#ifndef _threadpool_cpp_
+#define _threadpool_cpp_
+
+#include "threadpool.h"
+
+//Starts the given number of worker threads
+ThreadPool::ThreadPool(int threads):
+  running_(threads, (const void*)NULL),
+  workers_(threads),
+  stop_(false)
+{
+  lock_ = SDL_CreateMutex();
+  wake_ = SDL_CreateCond();
+  done_ = SDL_CreateCond();
+
+  for (int i = 0; i < threads; i++)
+    {
+      workers_[i].pool = this;
+      workers_[i].id = i;
+      threads_.push_back(SDL_CreateThread(workerMain, &workers_[i]));
+    }
+}
+
+//Drops any jobs not yet started, then waits for the threads to finish
+ThreadPool::~ThreadPool()
+{
+  SDL_LockMutex(lock_);
+  stop_ = true;
+  queue_.clear();
+  SDL_CondBroadcast(wake_);
+  SDL_UnlockMutex(lock_);
+
+  for (unsigned int i = 0; i < threads_.size(); i++)
+    {
+      SDL_WaitThread(threads_[i], NULL);
+    }
+
+  SDL_DestroyCond(done_);
+  SDL_DestroyCond(wake_);
+  SDL_DestroyMutex(lock_);
+}
+
+//Queues fn(owner, arg) to run on some worker thread
+void ThreadPool::submit(JobFunction fn, void* owner, int arg)
+{
+  Job job = {fn, owner, arg};
+  SDL_LockMutex(lock_);
+  queue_.push_back(job);
+  SDL_CondSignal(wake_);
+  SDL_UnlockMutex(lock_);
+}
+
+//Waits until every job from owner has finished
+void ThreadPool::wait(const void* owner)
+{
+  SDL_LockMutex(lock_);
+  while (busy(owner))
+    {
+      SDL_CondWait(done_, lock_);
+    }
+  SDL_UnlockMutex(lock_);
+}
+
+//Drops the jobs from owner that haven't started, then waits for the rest
+void ThreadPool::cancel(const void* owner)
+{
+  SDL_LockMutex(lock_);
+  for (std::deque<Job>::iterator i = queue_.begin(); i != queue_.end();)
+    {
+      if (i->owner == owner) i = queue_.erase(i);
+      else i++;
+    }
+  while (busy(owner))
+    {
+      SDL_CondWait(done_, lock_);
+    }
+  SDL_UnlockMutex(lock_);
+}
+
+//The pool shared by the whole game, started on first use
+ThreadPool& ThreadPool::shared()
+{
+  static ThreadPool pool(WORKER_THREADS);
+  return pool;
+}
+
+//Entry point for the threads
+int ThreadPool::workerMain(void* data)
+{
+  Worker* worker = (Worker*)data;
+  worker->pool->work(worker->id);
+  return 0;
+}
+
+//Runs jobs until the pool shuts down
+void ThreadPool::work(int id)
+{
+  SDL_LockMutex(lock_);
+  while (true)
+    {
+      while (!stop_ && queue_.empty())
+	{
+	  SDL_CondWait(wake_, lock_);
+	}
+      if (stop_) break;
+
+      //Take the next job and run it without holding the lock
+      Job job = queue_.front();
+      queue_.pop_front();
+      running_[id] = job.owner;
+      SDL_UnlockMutex(lock_);
+
+      job.fn(job.owner, job.arg);
+
+      SDL_LockMutex(lock_);
+      running_[id] = NULL;
+      SDL_CondBroadcast(done_);
+    }
+  SDL_UnlockMutex(lock_);
+}
+
+//Checks whether owner has jobs queued or running. Must hold lock_.
+bool ThreadPool::busy(const void* owner) const
+{
+  for (unsigned int i = 0; i < running_.size(); i++)
+    {
+      if (running_[i] == owner) return true;
+    }
+  for (std::deque<Job>::const_iterator i = queue_.begin(); i != queue_.end(); i++)
+    {
+      if (i->owner == owner) return true;
+    }
+  return false;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----ThreadPool Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  A fixed set of SDL worker threads that run jobs from a shared queue.
+  A job is a function, an owner pointer passed to it, and an integer argument.
+  The owner also tags the job, so everything queued by one object can be
+  waited on or cancelled together, such as when that object is destroyed.
+*/
+
+#ifndef _threadpool_h_
+#define _threadpool_h_
+
+#include <deque>
+#include <vector>
+#include "SDL/SDL.h"
+
+//The number of threads in the shared pool
+const int WORKER_THREADS = 3;
+
+class ThreadPool
+{
+ public:
+  typedef void (*JobFunction)(void* owner, int arg);
+
+  //Constructors/Destructor
+  //The destructor drops any jobs not yet started and waits for the rest
+  ThreadPool(int threads);
+  ~ThreadPool();
+
+  //Queues fn(owner, arg) to run on some worker thread
+  void submit(JobFunction fn, void* owner, int arg);
+
+  //Waits until every job from owner has finished
+  void wait(const void* owner);
+
+  //Drops the jobs from owner that haven't started, then waits for the rest
+  void cancel(const void* owner);
+
+  //Accessors
+  int threads() const {return threads_.size();}
+
+  //The pool shared by the whole game, started on first use
+  static ThreadPool& shared();
+
+ private:
+  struct Job
+  {
+    JobFunction fn;
+    void* owner;
+    int arg;
+  };
+
+  struct Worker
+  {
+    ThreadPool* pool;
+    int id;
+  };
+
+  //Entry point for the threads, and the loop each one runs
+  static int workerMain(void* data);
+  void work(int id);
+
+  //Checks whether owner has jobs queued or running. Must hold lock_.
+  bool busy(const void* owner) const;
+
+  //Jobs waiting to be run
+  std::deque<Job> queue_;
+
+  //The owner of the job each thread is running, or NULL if idle
+  std::vector<const void*> running_;
+
+  //The threads and their start data
+  std::vector<SDL_Thread*> threads_;
+  std::vector<Worker> workers_;
+
+  //Guards everything above
+  SDL_mutex* lock_;
+
+  //Signalled when a job is queued, and when a job finishes
+  SDL_cond* wake_;
+  SDL_cond* done_;
+
+  //Set when the pool is shutting down
+  bool stop_;
+};
+
+#endif
@@ -1,13 +1,20 @@
 /*
   Copyright (c) 2013 Auston Sterling
   See license.txt for copying permission.
-  
+
   -----Vec2f Class-----
   Auston Sterling
   austonst@gmail.com
 
   A class for storing and performing operations on a 2D vector.
   Originally based off of Justin Legakis' vectors.h.
+
+  Vec2 is templated on the component type. Vec2f, the float version, is what
+  the game uses. Prefer the squared-length and cosine helpers over length()
+  and angleBetween() in comparisons, since they avoid sqrt and acos.
+
+  Vec2x4 holds four vectors as separate x and y lanes, for batch loops over
+  packed arrays such as the fleet positions.
 */
 
 #ifndef _vec2f_h_
@@ -18,82 +25,145 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-class Vec2f
+template <typename T>
+class Vec2
 {
  public:
   //Constructors
-  Vec2f() {data[0] = data[1] = 0;}
-  Vec2f(const Vec2f &V) {
-    data[0] = V.data[0];
-    data[1] = V.data[1]; }
-  Vec2f(double d0, double d1) {
+  Vec2() {data[0] = data[1] = 0;}
+  Vec2(T d0, T d1) {
     data[0] = d0;
     data[1] = d1; }
-
-  //Assignment operator
-  const Vec2f& operator=(const Vec2f &V) {
-    data[0] = V.data[0];
-    data[1] = V.data[1];
-    return *this; }
+  template <typename U>
+  explicit Vec2(const Vec2<U> &V) {
+    data[0] = V.x();
+    data[1] = V.y(); }
 
   //Simple accessors and modifiers
-  double operator[](int i) const {
-    if (i >= 0 && i < 2) return data[i];
-    return 0; }
-  double x() const {return data[0];}
-  double y() const {return data[1];}
-  void setx(double x) {data[0] = x;}
-  void sety(double y) {data[1] = y;}
-  void set(double d0, double d1) {
+  //Indices are not checked, i must be 0 or 1
+  T operator[](int i) const {return data[i];}
+  T& operator[](int i) {return data[i];}
+  T x() const {return data[0];}
+  T y() const {return data[1];}
+  void setx(T x) {data[0] = x;}
+  void sety(T y) {data[1] = y;}
+  void set(T d0, T d1) {
     data[0] = d0;
     data[1] = d1; }
 
   //Common vector operations
-  double length() const {return sqrt(data[0]*data[0]+data[1]*data[1]);}
+  T lengthSq() const {return data[0]*data[0]+data[1]*data[1];}
+  T length() const {return std::sqrt(lengthSq());}
+  T distanceSq(const Vec2 &V) const {
+    T dx = V.data[0]-data[0], dy = V.data[1]-data[1];
+    return dx*dx + dy*dy; }
+  T distance(const Vec2 &V) const {return std::sqrt(distanceSq(V));}
   void normalize() {
-    double d = length();
-    if (d > 0) scale(1/d); }
-  void scale(double d) {scale(d,d);}
-  void scale(double d0, double d1) {
+    T d = lengthSq();
+    if (d > 0) scale(1/std::sqrt(d)); }
+  void scale(T d) {scale(d,d);}
+  void scale(T d0, T d1) {
     data[0] *= d0;
     data[1] *= d1;}
   void negate() {scale(-1);}
-  double dot2(const Vec2f &V) const {
+  T dot2(const Vec2 &V) const {
     return data[0]*V.data[0] + data[1]*V.data[1]; }
-  double angleBetween(const Vec2f &V) const {
-    return acos(dot2(V) / (length()*V.length())); }
+  T angleBetween(const Vec2 &V) const {
+    return std::acos(dot2(V) / (length()*V.length())); }
+
+  //Range checks without the square root
+  bool withinRange(T r) const {return lengthSq() <= r*r;}
+  bool withinRange(const Vec2 &V, T r) const {return distanceSq(V) <= r*r;}
+
+  //Checks whether the angle to V is at most acos(cosine), without calling acos
+  //angle(a,b) <= t is the same as a.b >= |a||b|cos(t), and both sides can be
+  //squared when their signs are known
+  bool angleWithin(const Vec2 &V, T cosine) const {
+    T d = dot2(V);
+    T bound = cosine * cosine * lengthSq() * V.lengthSq();
+    if (cosine >= 0) return d >= 0 && d * d >= bound;
+    return d >= 0 || d * d <= bound; }
 
   //Vector math operations
-  Vec2f& operator+=(const Vec2f &V) {
+  Vec2& operator+=(const Vec2 &V) {
     data[0] += V.data[0];
     data[1] += V.data[1];
     return *this; }
-  Vec2f& operator-=(const Vec2f &V) {
+  Vec2& operator-=(const Vec2 &V) {
     data[0] -= V.data[0];
     data[1] -= V.data[1];
     return *this; }
-  Vec2f& operator*=(double d) {
+  Vec2& operator*=(T d) {
     data[0] *= d;
     data[1] *= d;
     return *this; }
-  Vec2f& operator/=(double d) {
+  Vec2& operator/=(T d) {
     data[0] /= d;
     data[1] /= d;
     return *this; }
-  friend Vec2f operator+(const Vec2f &v1, const Vec2f &v2) {
-    Vec2f v3 = v1; v3 += v2; return v3; }
-  friend Vec2f operator-(const Vec2f &v1, const Vec2f &v2) {
-    Vec2f v3 = v1; v3 -= v2; return v3; }
-  friend Vec2f operator-(const Vec2f &V) {
-    Vec2f v2 = V; v2.negate(); return v2; }
-  friend Vec2f operator*(const Vec2f &v1, double d) {
-    Vec2f v2 = v1; v2.scale(d); return v2; }
-  friend Vec2f operator*(double d, const Vec2f &v1) {
+  friend Vec2 operator+(const Vec2 &v1, const Vec2 &v2) {
+    Vec2 v3 = v1; v3 += v2; return v3; }
+  friend Vec2 operator-(const Vec2 &v1, const Vec2 &v2) {
+    Vec2 v3 = v1; v3 -= v2; return v3; }
+  friend Vec2 operator-(const Vec2 &V) {
+    Vec2 v2 = V; v2.negate(); return v2; }
+  friend Vec2 operator*(const Vec2 &v1, T d) {
+    Vec2 v2 = v1; v2.scale(d); return v2; }
+  friend Vec2 operator*(T d, const Vec2 &v1) {
     return v1 * d; }
 
  private:
   //Representation
-  double data[2];
+  T data[2];
 };
-  
+
+typedef Vec2<float> Vec2f;
+typedef Vec2<double> Vec2d;
+
+//Four float vectors stored as lanes, so each operation is one loop over
+//four values that the compiler can turn into a single SIMD instruction
+class Vec2x4
+{
+ public:
+  static const int WIDTH = 4;
+
+  //Constructors
+  Vec2x4() {
+    for (int i = 0; i < WIDTH; i++) x[i] = y[i] = 0; }
+
+  //Reads or writes four consecutive entries of separate x and y arrays
+  void load(const float* px, const float* py) {
+    for (int i = 0; i < WIDTH; i++) {x[i] = px[i]; y[i] = py[i];} }
+  void store(float* px, float* py) const {
+    for (int i = 0; i < WIDTH; i++) {px[i] = x[i]; py[i] = y[i];} }
+
+  //Lane-wise vector operations
+  void lengthSq(float* out) const {
+    for (int i = 0; i < WIDTH; i++) out[i] = x[i]*x[i] + y[i]*y[i]; }
+  void normalize() {
+    for (int i = 0; i < WIDTH; i++) {
+      float d = x[i]*x[i] + y[i]*y[i];
+      float inv = (d > 0) ? 1.0f / std::sqrt(d) : 0.0f;
+      x[i] *= inv;
+      y[i] *= inv; } }
+  void scale(const float* s) {
+    for (int i = 0; i < WIDTH; i++) {x[i] *= s[i]; y[i] *= s[i];} }
+
+  Vec2x4& operator+=(const Vec2x4 &V) {
+    for (int i = 0; i < WIDTH; i++) {x[i] += V.x[i]; y[i] += V.y[i];}
+    return *this; }
+  Vec2x4& operator-=(const Vec2x4 &V) {
+    for (int i = 0; i < WIDTH; i++) {x[i] -= V.x[i]; y[i] -= V.y[i];}
+    return *this; }
+  Vec2x4& operator*=(float d) {
+    for (int i = 0; i < WIDTH; i++) {x[i] *= d; y[i] *= d;}
+    return *this; }
+  friend Vec2x4 operator-(const Vec2x4 &v1, const Vec2x4 &v2) {
+    Vec2x4 v3 = v1; v3 -= v2; return v3; }
+
+  //Representation, one lane per vector
+  float x[WIDTH] __attribute__((aligned(16)));
+  float y[WIDTH] __attribute__((aligned(16)));
+};
+
 #endif
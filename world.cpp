@@ -0,0 +1,695 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----GameWorld Class Implementation-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Implementation of the GameWorld class, containing the simulation logic that
+  used to live in the main loop of "Galcon".
+*/
+
+#ifndef _world_cpp_
+#define _world_cpp_
+
+#include "world.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
+
+//Regular constructor
+GameWorld::GameWorld(const std::vector<ShipStats>& shipstats, SDL_Surface* planetImg[], SDL_Surface* indicator[]):
+  shipstats_(shipstats),
+  indicator_(indicator),
+  ship0rate_(1.0)
+{
+  //Grid cells must be at least as large as the longest interception range
+  interceptRange_ = 0;
+  for (unsigned int i = 0; i < shipstats_.size(); i++)
+    {
+      interceptRange_ = std::max(interceptRange_, float(shipstats_[i].interceptRange));
+    }
+
+  for (int i = 0; i < NUM_PLANET_IMAGES; i++)
+    {
+      planetImg_[i] = planetImg[i];
+    }
+
+  //One list of allowed buildings for each planet type
+  buildRules_.resize(2);
+}
+
+//Adds a building type to the world, allowing it on the given planet type
+//Returns a pointer to the stored building so it can be configured further
+Building* GameWorld::addBuilding(const Building& inbuild, int planetType)
+{
+  buildings_.push_back(inbuild);
+  buildRules_[planetType].push_back(&(buildings_.back()));
+  return &(buildings_.back());
+}
+
+//Creates the home planets, then the rest of the planets at random
+void GameWorld::generate(float ship0rate)
+{
+  ship0rate_ = ship0rate;
+
+  //First, create two home planets
+  planets_.push_back(Planet(planetImg_[PLANET_IMAGE_NORMAL], 1.0,
+			    Vec2f(rand()%100, 100 + rand()%(LEVEL_HEIGHT-200)), 0));
+  planets_.back().setOwner(1, indicator_);
+  planets_.back().setShipRate(0, ship0rate_);
+  planets_.back().setRotSpeed(M_PI/20);
+  planets_.back().addShips(3, 0);
+  planets_.push_back(Planet(planetImg_[PLANET_IMAGE_NORMAL], 1.0,
+			    Vec2f(LEVEL_WIDTH-(2*UNSCALED_PLANET_RADIUS)-(rand()%100),
+				  100 + rand()%(LEVEL_HEIGHT-200)), 0));
+  planets_.back().setOwner(2, indicator_);
+  planets_.back().setShipRate(0, ship0rate_);
+  planets_.back().setRotSpeed(M_PI/20);
+  planets_.back().addShips(3, 0);
+
+  //Now repeatedly create planets until either a target density is reached
+  //or we go too many tries without finding a spot for a new planet.
+  char tries = 0;
+  char maxTries = 10;
+  double density = 0.13;
+  double totalSize = LEVEL_WIDTH*LEVEL_HEIGHT;
+  double currentSize = M_PI*UNSCALED_PLANET_RADIUS*UNSCALED_PLANET_RADIUS*2;
+  double spacing = 23;
+
+  while (currentSize/totalSize < density && tries < maxTries)
+    {
+      //Create a new planet at a completely random location with a random size
+      //For now, make half normal and half volcanic
+      float psize = (double(rand())/double(RAND_MAX))*0.7 + 0.5;
+      Planet p(planetImg_[PLANET_IMAGE_NORMAL], psize,
+               Vec2f(rand()%(LEVEL_WIDTH-int(2*UNSCALED_PLANET_RADIUS*psize)),
+                     rand()%(LEVEL_HEIGHT-int(2*UNSCALED_PLANET_RADIUS*psize))), 0);
+      if (rand()%2 == 0)
+        {
+          p.setType(0);
+          p.setImage(planetImg_[PLANET_IMAGE_NORMAL]);
+        }
+      else
+        {
+          p.setType(1);
+          p.setImage(planetImg_[PLANET_IMAGE_LAVA]);
+        }
+
+      //Make sure it doesn't collide with any other planets
+      bool skip = false;
+      for (planetIter pi = planets_.begin(); pi != planets_.end(); pi++)
+	{
+	  Vec2f ppos = p.pos()+Vec2f(UNSCALED_PLANET_RADIUS*p.size(),UNSCALED_PLANET_RADIUS*p.size());
+	  Vec2f pipos = pi->pos()+Vec2f(UNSCALED_PLANET_RADIUS*pi->size(),UNSCALED_PLANET_RADIUS*pi->size());
+	  float minDist = p.size()*UNSCALED_PLANET_RADIUS +
+	    pi->size()*UNSCALED_PLANET_RADIUS + spacing;
+	  if (ppos.distanceSq(pipos) < minDist * minDist)
+	    {
+	      //There's a collision. Increment tries and try again
+	      tries++;
+	      skip = true;
+	      break;
+	    }
+	}
+      if (skip) continue;
+
+      //At this point, we know there's no collision. Reset tries
+      tries = 0;
+
+      //Add a few more random attributes
+      p.setOwner(0, indicator_);
+      p.setShipRate(0, ship0rate_);
+      p.setRotSpeed((fmod(rand(),M_PI)/5) - M_PI/10);
+      p.setDifficulty(p.size()*20 + rand()%15 - 9);
+
+      //Add this planet to the current size
+      currentSize += M_PI*(UNSCALED_PLANET_RADIUS*p.size())*(UNSCALED_PLANET_RADIUS*p.size());
+
+      //Add it to the list, p isn't needed anymore
+      planets_.push_back(std::move(p));
+    }
+
+  //The planets are all placed, so measure the distances between them
+  planetMap_.build(planets_, shipstats_);
+}
+
+//Adds an active AI controlling the given player
+//Should be called after generate() so the AI knows its planets
+void GameWorld::addAI(char player, GalconAISettings setup)
+{
+  ai_.push_back(GalconAI(player, setup));
+  ai_.back().init(planets_, shipstats_);
+  ai_.back().activate();
+}
+
+//Returns the planet containing the given point, or NULL if there is none
+Planet* GameWorld::planetAt(Vec2f point)
+{
+  for (planetIter i = planets_.begin(); i != planets_.end(); i++)
+    {
+      //See if distance from center is less than planet radius
+      Vec2f center(i->x() + (UNSCALED_PLANET_RADIUS * i->size()),
+		   i->y() + (UNSCALED_PLANET_RADIUS * i->size()));
+
+      float radius = UNSCALED_PLANET_RADIUS * i->size();
+      if (point.distanceSq(center) < radius * radius)
+	{
+	  return &(*i);
+	}
+    }
+  return NULL;
+}
+
+//Splits ratio of the given ship type off of source and sends it to dest
+//Returns false if there were no ships to send
+bool GameWorld::sendFleet(Planet* source, Planet* dest, float ratio, int type)
+{
+  //Split ships from the source planet
+  int transfer = source->splitShips(ratio, type);
+
+  //Make sure we actually have a ship in the fleet
+  if (transfer <= 0) return false;
+
+  //Add the new fleet
+  fleets_.add(transfer, type, shipstats_[type], source, dest);
+  return true;
+}
+
+//Starts construction of the index'th building allowed on the planet's type
+void GameWorld::build(Planet* planet, unsigned int index)
+{
+  if (buildRules_[planet->type()].size() <= index) return;
+
+  std::list<Building*>::const_iterator b = buildRules_[planet->type()].begin();
+  for (unsigned int i = 0; i < index; i++) b++;
+
+  planet->build(*b, buildRules_);
+}
+
+//Advances the simulation by dt milliseconds
+//Every object is updated with the same clock, so dt may be any length
+void GameWorld::step(int dt)
+{
+  clock_.advance(dt);
+  beams_.clear();
+
+  updateFleets();
+  updatePlanets();
+  updateProjectiles();
+  updateAI();
+}
+
+//Moves fleets, resolves arrivals and handles interception
+//Leaves grid_ holding every remaining fleet for the rest of the step
+void GameWorld::updateFleets()
+{
+  //Move every fleet at once
+  std::vector<FleetId> arrived;
+  fleets_.updateAll(clock_, arrived);
+
+  //Resolve arrivals at destinations
+  for (std::vector<FleetId>::iterator i = arrived.begin(); i != arrived.end(); i++)
+    {
+      resolveArrival(fleets_[fleets_.find(*i)]);
+
+      //Delete the fleet
+      //Projectiles still aimed at it will find its handle stale
+      fleets_.remove(*i);
+    }
+
+  //Sort the surviving fleets into the grid
+  grid_.build(fleets_, interceptRange_);
+
+  //Check for interception
+  std::vector<unsigned int> nearby;
+  for (unsigned int i = 0; i < fleets_.size(); i++)
+    {
+      int itype = fleets_.type(i);
+
+      //Compare against every fleet in neighbouring cells
+      nearby.clear();
+      grid_.query(fleets_.pos(i), shipstats_[itype].interceptRange, nearby);
+      for (std::vector<unsigned int>::iterator m = nearby.begin(); m != nearby.end(); m++)
+	{
+	  unsigned int j = *m;
+
+	  //Atempt interception
+	  char status = fleets_.intercept(i, j, shipstats_);
+
+	  //Greater than 0: Record the beam for display
+	  if (status <= 0) continue;
+	  beams_.push_back(beam(fleets_.pos(i), fleets_.pos(j)));
+
+	  //Equal to 2: Dealt damage, but didn't notify
+	  if (status == 2)
+	    {
+	      //Notify the AI before we go around deleting things
+	      for (std::list<GalconAI>::iterator k = ai_.begin(); k != ai_.end(); k++)
+		{
+		  if (k->player() == fleets_.owner(j))
+		    {
+		      k->notifyFleetDamage(std::min(double(shipstats_[itype].interceptDamage),
+						    double(fleets_.totalDefense(j, shipstats_))));
+		    }
+		}
+	    }
+
+	  //Equal to 3: Destroy target
+	  if (status != 3) break;
+
+	  //We can have the projectile code handle the cleanup later
+	  //Create a fake projectile right on top of it to deal the final blow
+	  Payload shot = {PAYLOAD_DAMAGE, shipstats_[itype].interceptDamage*fleets_.ships(i)*2};
+	  projectiles_.push_back(Projectile(fleets_.pos(j), fleets_.id(j), shot,
+					    shipstats_[fleets_.type(j)].speed*2));
+
+	  //Don't attack more than one ship
+	  break;
+	}
+    }
+}
+
+//Resolves a fleet reaching its destination planet and notifies AIs of the result
+void GameWorld::resolveArrival(const Fleet& fleet)
+{
+  //Check if friendly or hostile
+  if (fleet.dest()->owner() == fleet.owner())
+    {
+      //Add the fleet to the new planet
+      fleet.dest()->addShips(fleet.ships(), fleet.type());
+      return;
+    }
+
+  //Hostile, attack!
+  //Get ship counts before the attack
+  std::vector<int> ships1 = fleet.dest()->shipcount();
+  int oldowner = fleet.dest()->owner();
+
+  //Actually do the attack
+  fleet.dest()->takeAttack(fleet.ships(), fleet.type(), fleet.owner(), shipstats_, indicator_);
+
+  //Get ship counts after the attack
+  std::vector<int> ships2 = fleet.dest()->shipcount();
+
+  //Notify the defending AI about the losses
+  for (std::list<GalconAI>::iterator j = ai_.begin(); j != ai_.end(); j++)
+    {
+      if (oldowner != j->player()) continue;
+      float newdefense = 0;
+      for (unsigned int k = 0; k < ships1.size(); k++)
+	{
+	  int diff;
+	  //If ownership has changed
+	  if (oldowner != fleet.dest()->owner())
+	    {
+	      diff = ships1[k];
+	      j->notifyPlanetLoss(fleet.dest());
+	    }
+	  else
+	    {
+	      diff = ships1[k] - ships2[k];
+	    }
+
+	  newdefense += diff * shipstats_[k].defense;
+	}
+      j->notifyDefendLoss(newdefense);
+    }
+
+  //Notify the attacking AI about the losses
+  for (std::list<GalconAI>::iterator j = ai_.begin(); j != ai_.end(); j++)
+    {
+      if (fleet.owner() != j->player()) continue;
+      float lost;
+
+      //If the attack failed
+      if (fleet.dest()->owner() != fleet.owner())
+	{
+	  //Lost everything
+	  lost = fleet.ships();
+	}
+      else //Successful attack
+	{
+	  //Lose the difference
+	  lost = fleet.ships() - fleet.dest()->totalDefense(shipstats_);
+	  j->notifyPlanetGain(fleet.dest());
+	}
+
+      j->notifyAttackLoss(lost);
+    }
+}
+
+//Updates planets and the effects of their buildings
+void GameWorld::updatePlanets()
+{
+  for (planetIter i = planets_.begin(); i != planets_.end(); i++)
+    {
+      //Get ship counts before the update
+      std::vector<int> ships1 = i->shipcount();
+
+      //Update the planet
+      i->update(clock_);
+
+      //Get ship counts after the update
+      std::vector<int> ships2 = i->shipcount();
+
+      //Notify a controlling AI about the construction
+      for (std::list<GalconAI>::iterator j = ai_.begin(); j != ai_.end(); j++)
+	{
+	  if (i->owner() != j->player()) continue;
+	  float newattack = 0;
+	  float newdefense = 0;
+	  for (unsigned int k = 0; k < ships1.size(); k++)
+	    {
+	      int diff = ships2[k] - ships1[k];
+	      newattack += diff * shipstats_[k].attack;
+	      newdefense += diff * shipstats_[k].defense;
+	    }
+	  j->notifyConstruction(newattack, newdefense);
+	}
+
+      //If this is a lava planet and it is depleted, replace the image
+      if (i->typeInfo() < 0 && i->type() == 1)
+	{
+	  i->setImage(planetImg_[PLANET_IMAGE_DEPLETED]);
+	  i->setTypeInfo(0);
+	  i->setRotSpeed(0);
+	  i->setShipRate(0, ship0rate_ * PLANET1_DEPLETION_PENALTY);
+	}
+
+      updateBuildings(*i);
+    }
+}
+
+//Handles effects from a planet's buildings to other objects
+//Fleets in range are found through grid_, which updateFleets() leaves current
+void GameWorld::updateBuildings(Planet& planet)
+{
+  std::vector<unsigned int> nearby;
+
+  for (unsigned int j = 0; j < planet.buildcount(); j++)
+    {
+      //Get the building
+      BuildingInstance* b = planet.building(j);
+
+      //Skip over nonexistant and incomplete buildings
+      if (!(b->exists()) || j == Uint32(planet.buildIndex())) continue;
+
+      //Only fire and aura effects involve other objects
+      const BuildingEffect& effect = b->effect();
+      if (effect.type != EFFECT_FIRE && effect.type != EFFECT_AURA) continue;
+
+      //Try to make it fire, remember result
+      bool fire = b->fire();
+
+      //Find the enemy fleets that might be in range
+      Vec2f coords = planet.buildcoords(j);
+      nearby.clear();
+      grid_.query(coords, b->range(), nearby);
+
+      //Fire projectile: fire <payload> <amount> <speed as multiplier>
+      if (effect.type == EFFECT_FIRE)
+	{
+	  //Loop over all potential target fleets, find closest
+	  int closest = -1;
+	  float closestDistSq = -1;
+	  float rangeSq = b->range() * b->range();
+	  for (std::vector<unsigned int>::iterator n = nearby.begin(); n != nearby.end(); n++)
+	    {
+	      Fleet k = fleets_[*n];
+
+	      //Only check further if it's an enemy fleet
+	      if (k.owner() == planet.owner()) continue;
+	      //Compute the squared distance between them
+	      float distSq = coords.distanceSq(k.pos());
+
+	      //Continue if the fleet is out of range
+	      if (distSq > rangeSq) continue;
+
+	      //Compare with previous best
+	      if (distSq < closestDistSq || closestDistSq < -0.5)
+		{
+		  closestDistSq = distSq;
+		  closest = *n;
+		}
+	    }
+
+	  //Fire a projectile from the building to the fleet
+	  if (closest >= 0 && fire)
+	    {
+	      projectiles_.push_back(Projectile(coords, fleets_.id(closest), effect.payload, effect.speed));
+	    }
+	}
+
+      //Aura: aura <payload> <amount> [total]
+      if (effect.type == EFFECT_AURA)
+	{
+	  //Find number of ships in range
+	  int shipcount = 0;
+	  for (std::vector<unsigned int>::iterator n = nearby.begin(); n != nearby.end(); n++)
+	    {
+	      Fleet k = fleets_[*n];
+
+	      //Only check further if it's an enemy fleet
+	      if (k.owner() == planet.owner()) continue;
+	      //Check the distance between them
+	      if (coords.withinRange(k.pos(), b->range())) shipcount += k.ships();
+	    }
+
+	  //Deal damage with a fake projectile
+	  if (fire)
+	    {
+	      bool hit = false;
+	      for (std::vector<unsigned int>::iterator n = nearby.begin(); n != nearby.end(); n++)
+		{
+		  Fleet k = fleets_[*n];
+
+		  //Only check further if it's an enemy fleet
+		  if (k.owner() == planet.owner()) continue;
+		  //Check the distance between them
+		  if (!coords.withinRange(k.pos(), b->range())) continue;
+		  hit = true;
+
+		  //Divide appropriately if needed
+		  Payload payload = effect.payload;
+		  if (effect.total)
+		    {
+		      payload.amount *= float(k.ships())/float(shipcount);
+		    }
+		  //Depleted volcanic planets don't do as much
+		  if (planet.type() == 1 && planet.typeInfo() <= 0)
+		    {
+		      payload.amount *= PLANET1_DEPLETION_PENALTY;
+		    }
+		  //Create the projectile
+		  projectiles_.push_back(Projectile(k.pos(), k.id(), payload, 1));
+		}
+
+	      //Volcanic planets will lost some fuel
+	      if (planet.type() == 1 && hit && planet.typeInfo() != 0)
+		{
+		  planet.setTypeInfo(planet.typeInfo()-PLANET1_DEPLETION_RATE);
+		  if (planet.typeInfo() == 0) planet.setTypeInfo(-1);
+		}
+	    }
+	}
+    } //for each building
+}
+
+//Moves projectiles and resolves their impacts
+void GameWorld::updateProjectiles()
+{
+  for (unsigned int i = 0; i < projectiles_.size(); i++)
+    {
+      Projectile& p = projectiles_[i];
+      if (p.expired()) continue;
+
+      //Projectiles whose target has been destroyed simply fizzle out
+      int target = fleets_.find(p.target());
+      if (target < 0)
+	{
+	  p.expire();
+	  continue;
+	}
+      p.update(clock_, fleets_.pos(target));
+
+      //Check if the projectile has hit its target fleet
+      if (!p.pos().withinRange(fleets_.pos(target), 12.345)) continue; //MAGIC NUMBER >:(
+
+      //Deliver the payload, removing the fleet if it is destroyed
+      if (!deliver(p.payload(), target))
+	{
+	  fleets_.remove(p.target());
+	}
+
+      //Either way, this projectile is spent
+      p.expire();
+    }
+
+  //Remove spent projectiles, keeping the rest packed together
+  projectiles_.erase(std::remove_if(projectiles_.begin(), projectiles_.end(),
+				    [](const Projectile& p){return p.expired();}),
+		     projectiles_.end());
+}
+
+//Applies a payload to a fleet, returning false if the fleet is destroyed
+bool GameWorld::deliver(const Payload& payload, unsigned int target)
+{
+  //Damage: deal the amount as damage
+  if (payload.kind == PAYLOAD_DAMAGE)
+    {
+      //Notify the AI before we go around deleting things
+      for (std::list<GalconAI>::iterator j = ai_.begin(); j != ai_.end(); j++)
+	{
+	  if (j->player() == fleets_.owner(target))
+	    {
+	      j->notifyFleetDamage(std::min(double(payload.amount), double(fleets_.totalDefense(target, shipstats_))));
+	    }
+	}
+
+      //Check to see if the fleet is destroyed by this
+      return fleets_.takeHit(target, payload.amount, shipstats_);
+    }
+
+  //Anything else does nothing
+  return true;
+}
+
+//Lets every AI take its turn and carries out the commands
+void GameWorld::updateAI()
+{
+  for (std::list<GalconAI>::iterator i = ai_.begin(); i != ai_.end(); i++)
+    {
+      execute(i->update(planets_, planetMap_, shipstats_, buildRules_, clock_));
+    }
+}
+
+//Executes a list of AI commands
+void GameWorld::execute(const commandList& com)
+{
+  for (commandList::const_iterator j = com.begin(); j != com.end(); j++)
+    {
+      //Extract the info from the command
+      Planet* source = j->first;
+      int amount = j->second.first;
+      Planet* dest = j->second.second;
+
+      //Handle building construction
+      if (source == dest)
+	{
+	  build(source, amount);
+	  continue;
+	}
+
+      //Get the number of ships from the source
+      std::vector<int> ships = source->shipcount();
+
+      //Send out a fleet for each ship type used
+      std::vector<int> newfleet;
+      newfleet.resize(ships.size());
+      int total = 0;
+      for (unsigned int k = 0; k < ships.size(); k++)
+	{
+	  //Handle it differently for attack or defense
+	  float typeTotal;
+	  if (dest->owner() == source->owner())
+	    {
+	      //Check the total defense of this ship type
+	      typeTotal = ships[k] * shipstats_[k].defense;
+	    }
+	  else
+	    {
+	      //Check the total attack of this ship type
+	      typeTotal = ships[k] * shipstats_[k].attack;
+	    }
+
+	  //If there's more ships requested than there are of this type
+	  if (total + typeTotal <= amount)
+	    {
+	      //Add them all
+	      newfleet[k] += ships[k];
+	      total += typeTotal;
+	    }
+	  else //More ships than space in the requested fleet
+	    {
+	      //Find the proper amount
+	      //# of ships to send = defense requested / def per ship
+	      float properAmount = (amount - total) / (typeTotal / ships[k]);
+	      newfleet[k] += properAmount;
+	      break;
+	    }
+	}
+
+      //Fleet is built, send each type that has some ships
+      for (unsigned int k = 0; k < newfleet.size(); k++)
+	{
+	  if (newfleet[k] == 0) continue;
+	  fleets_.add(newfleet[k], k, shipstats_[k], source, dest);
+
+	  //Also subtract the fleet from the original planet
+	  newfleet[k] *= -1;
+	  source->addShips(newfleet[k], k);
+	}
+    }
+}
+
+//Checks whether a rectangle in world coordinates overlaps an area
+static inline bool inView(const SDL_Rect& area, float x, float y, float w, float h)
+{
+  return x < area.x + area.w && y < area.y + area.h &&
+    x + w > area.x && y + h > area.y;
+}
+
+//Records what the world looks like inside area for the renderer
+void GameWorld::record(RenderList& list, const SDL_Rect& area, const Planet* selected)
+{
+  list.clear();
+
+  //Record interception beams
+  for (std::vector<beam>::const_iterator i = beams_.begin(); i != beams_.end(); i++)
+    {
+      int x1 = std::min(i->first.x(), i->second.x()), y1 = std::min(i->first.y(), i->second.y());
+      int x2 = std::max(i->first.x(), i->second.x()), y2 = std::max(i->first.y(), i->second.y());
+      if (!inView(area, x1, y1, x2 - x1 + 1, y2 - y1 + 1)) continue;
+      list.beam(i->first, i->second);
+    }
+
+  //Record fleets, for now just a box
+  for (unsigned int i = 0; i < fleets_.size(); i++)
+    {
+      if (!inView(area, fleets_.x(i) - 10, fleets_.y(i) - 10, 20, 20)) continue;
+      Vec2f moved = fleets_.vel(i) * (fleets_.speed(i) * clock_.seconds());
+      list.box(fleets_.pos(i) - Vec2f(10, 10), moved, 20, 20, 0x000000);
+    }
+
+  //Record planets, asking the planet map which are near the area
+  onScreen_.clear();
+  planetMap_.visible(area, onScreen_);
+  for (unsigned int k = 0; k < onScreen_.size(); k++)
+    {
+      Planet* p = planetMap_.planet(onScreen_[k]);
+      SDL_Rect b = p->bounds();
+      if (!inView(area, b.x, b.y, b.w, b.h)) continue;
+
+      //If this planet is selected, add an indicator
+      if (p == selected)
+	{
+	  int side = UNSCALED_PLANET_RADIUS * p->size() * 2 + 2*PLANET_SELECT_MARGIN;
+	  list.box(p->pos() - Vec2f(PLANET_SELECT_MARGIN, PLANET_SELECT_MARGIN), Vec2f(0, 0),
+		   side, side, 0x646464);
+	}
+
+      p->record(list, clock_.dt());
+    }
+
+  //Record projectiles, for now just a box
+  for (projectileIter i = projectiles_.begin(); i != projectiles_.end(); i++)
+    {
+      if (i->expired() || !inView(area, i->pos().x() - 5, i->pos().y() - 5, 10, 10)) continue;
+      list.box(i->pos() - Vec2f(5, 5), i->moved(), 10, 10, 0x000000);
+    }
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+  Copyright (c) 2013 Auston Sterling
+  See license.txt for copying permission.
+
+  -----GameWorld Class Declaration-----
+  Auston Sterling
+  austonst@gmail.com
+
+  Header for the GameWorld class, which owns all of the simulation state for
+  "Galcon" (planets, fleets, projectiles and AI players) and advances it with
+  step(). Nothing in step() touches the screen, so a world can be run without
+  ever setting a video mode. Rendering is left to a Renderer, which draws the
+  RenderList that record() fills in after each step.
+*/
+
+#ifndef _world_h_
+#define _world_h_
+
+#include <list>
+#include <vector>
+#include "SDL/SDL.h"
+#include "planet.h"
+#include "planetmap.h"
+#include "fleet.h"
+#include "projectile.h"
+#include "ai.h"
+#include "fleetstore.h"
+#include "fleetgrid.h"
+#include "renderlist.h"
+#include "vec2f.h"
+#include "shipstats.h"
+#include "simclock.h"
+
+const int LEVEL_WIDTH = 1000;
+const int LEVEL_HEIGHT = 750;
+
+//Indices into the planet image array given to the world
+const int PLANET_IMAGE_NORMAL = 0;
+const int PLANET_IMAGE_LAVA = 1;
+const int PLANET_IMAGE_DEPLETED = 2;
+const int NUM_PLANET_IMAGES = 3;
+
+//An interception beam fired during the last step, from attacker to target
+typedef std::pair<Vec2f, Vec2f> beam;
+
+class GameWorld
+{
+ public:
+  //Constructors
+  //The images are not copied and must outlive the world
+  GameWorld(const std::vector<ShipStats>& shipstats, SDL_Surface* planetImg[], SDL_Surface* indicator[]);
+
+  //Setup functions
+  Building* addBuilding(const Building& inbuild, int planetType);
+  void generate(float ship0rate);
+  void addAI(char player, GalconAISettings setup);
+
+  //Accessors
+  std::list<Planet>& planets() {return planets_;}
+  const std::list<Planet>& planets() const {return planets_;}
+  const FleetStore& fleets() const {return fleets_;}
+  const std::vector<Projectile>& projectiles() const {return projectiles_;}
+  const std::vector<ShipStats>& shipstats() const {return shipstats_;}
+  const std::vector<std::list<Building*> >& buildRules() const {return buildRules_;}
+  const std::vector<beam>& beams() const {return beams_;}
+  const SimClock& clock() const {return clock_;}
+  const PlanetMap& planetMap() const {return planetMap_;}
+  Planet* planetAt(Vec2f point);
+
+  //Player commands
+  bool sendFleet(Planet* source, Planet* dest, float ratio, int type);
+  void build(Planet* planet, unsigned int index);
+
+  //Advances the simulation by dt milliseconds
+  void step(int dt);
+
+  //Replaces list with what the world looks like after the last step. Does not modify the simulation.
+  //Only things inside area are recorded, and selected gets a box behind it
+  void record(RenderList& list, const SDL_Rect& area, const Planet* selected);
+
+ private:
+  //Parts of step()
+  void updateFleets();
+  void updatePlanets();
+  void updateBuildings(Planet& planet);
+  void updateProjectiles();
+  void updateAI();
+  void execute(const commandList& com);
+
+  //Notifies AIs about the result of a fleet attacking its destination
+  void resolveArrival(const Fleet& fleet);
+
+  //Applies a payload to a fleet, returning false if the fleet is destroyed
+  bool deliver(const Payload& payload, unsigned int target);
+
+  //The statistics for each ship type
+  std::vector<ShipStats> shipstats_;
+
+  //All building types and the types allowed on each planet type
+  std::list<Building> buildings_;
+  std::vector<std::list<Building*> > buildRules_;
+
+  //The objects in the world
+  std::list<Planet> planets_;
+  FleetStore fleets_;
+  std::vector<Projectile> projectiles_;
+  std::list<GalconAI> ai_;
+
+  //Distances between planets, built once the map is generated
+  PlanetMap planetMap_;
+
+  //Grid of fleet positions for range queries, rebuilt each step
+  FleetGrid grid_;
+
+  //The longest interception range of any ship type
+  float interceptRange_;
+
+  //Interception beams fired during the last step
+  std::vector<beam> beams_;
+
+  //The planets record() found near its area, kept to reuse its memory
+  std::vector<int> onScreen_;
+
+  //Images needed to change planet state
+  SDL_Surface* planetImg_[NUM_PLANET_IMAGES];
+  SDL_Surface** indicator_;
+
+  //The production rate of ship 0 on a normal planet
+  float ship0rate_;
+
+  //The simulation clock, advanced once per step
+  SimClock clock_;
+};
+
+#endif